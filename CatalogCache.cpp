@@ -0,0 +1,288 @@
+#include "CatalogCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+#include "CatalogReader.h"
+#include "FacetDictionary.h"
+#include "GameTable.h"
+
+using namespace std;
+
+#define CATALOG_CACHE_MAGIC "PIXBOXC"
+#define CATALOG_CACHE_VERSION 6
+
+namespace
+{
+  class Writer
+  {
+    public:
+      void u32(uint32_t value) { _buffer.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+      void u64(uint64_t value) { _buffer.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+      void str(const string& value) { u32(value.size()); _buffer.append(value); }
+      const string& buffer() const { return _buffer; }
+    private:
+      string _buffer;
+  };
+
+  // Bounds-checked reads: a truncated or corrupt cache only sets the error flag
+  class Reader
+  {
+    public:
+      Reader(const char* data, size_t size): _data(data), _size(size), _offset(0), _error(false) {}
+      bool error() const { return _error; }
+      bool atEnd() const { return _offset == _size; }
+
+      uint32_t u32() { uint32_t value(0); read(&value, sizeof(value)); return value; }
+      uint64_t u64() { uint64_t value(0); read(&value, sizeof(value)); return value; }
+      string_view str()
+      {
+        uint32_t length = u32();
+        if(_error || length > _size - _offset)
+        {
+          _error = true;
+          return string_view();
+        }
+        string_view res(_data + _offset, length);
+        _offset += length;
+        return res;
+      }
+
+    private:
+      void read(void* target, size_t size)
+      {
+        if(_error || size > _size - _offset)
+        {
+          _error = true;
+          return;
+        }
+        memcpy(target, _data + _offset, size);
+        _offset += size;
+      }
+
+      const char* _data;
+      size_t _size;
+      size_t _offset;
+      bool _error;
+  };
+}
+
+class CatalogCache::Private
+{
+  public:
+    Private(const string& cachePath);
+    ~Private(){}
+
+    static uint64_t hash(const char* data, size_t size);
+    static void writeDictionary(Writer& writer, const FacetDictionary& dictionary,
+                                const vector<unsigned int>& values, vector<unsigned int>& localIds);
+    static bool readDictionary(Reader& reader, FacetDictionary& dictionary, vector<unsigned int>& ids);
+
+    string _cachePath;
+    bool _identified;
+    uint64_t _dataSize;
+    uint64_t _dataTime;
+    uint64_t _dataHash;
+};
+
+CatalogCache::Private::Private(const string& cachePath):
+  _cachePath(cachePath),
+  _identified(false),
+  _dataSize(0),
+  _dataTime(0),
+  _dataHash(0)
+{}
+
+uint64_t CatalogCache::Private::hash(const char* data, size_t size)
+{
+  // FNV-1a
+  uint64_t res = 14695981039346656037ULL;
+  for(size_t ii = 0; ii < size; ++ii)
+  {
+    res ^= (unsigned char) data[ii];
+    res *= 1099511628211ULL;
+  }
+  return res;
+}
+
+void CatalogCache::Private::writeDictionary(Writer& writer, const FacetDictionary& dictionary,
+                                            const vector<unsigned int>& values, vector<unsigned int>& localIds)
+{
+  // Only the values used by the catalog are written, in the order of the
+  // sorted facet vector: local id n is the n-th value of the facet
+  localIds.assign(dictionary.size(), 0);
+  writer.u32(values.size());
+  for(unsigned int ii = 0; ii < values.size(); ++ii)
+  {
+    localIds[values[ii]] = ii;
+    writer.str(dictionary.value(values[ii]));
+  }
+}
+
+bool CatalogCache::Private::readDictionary(Reader& reader, FacetDictionary& dictionary, vector<unsigned int>& ids)
+{
+  uint32_t count = reader.u32();
+  if(reader.error())
+    return false;
+
+  ids.clear();
+  for(unsigned int ii = 0; ii < count && !reader.error(); ++ii)
+    ids.push_back(dictionary.intern(reader.str()));
+  return !reader.error();
+}
+
+CatalogCache::CatalogCache(const string& cachePath):
+  d(new Private(cachePath))
+{}
+
+CatalogCache::~CatalogCache()
+{
+  delete d;
+}
+
+bool CatalogCache::identify(const string& dataPath, const char* data, size_t size)
+{
+  d->_identified = false;
+
+  struct stat info;
+  if(stat(dataPath.c_str(), &info) != 0)
+    return false;
+
+  d->_dataSize = size;
+  d->_dataTime = info.st_mtime;
+  d->_dataHash = Private::hash(data, size);
+  d->_identified = true;
+  return true;
+}
+
+bool CatalogCache::load(GameTable& games,
+                        vector<uint64_t>& rowKeys,
+                        vector<unsigned int>& types,
+                        vector<unsigned int>& devices,
+                        vector<unsigned int>& families,
+                        vector<string>& prepareCommands,
+                        vector<string>& collectionNames,
+                        vector<string>& collectionQueries) const
+{
+  if(!d->_identified)
+    return false;
+
+  CatalogReader file;
+  if(!file.open(d->_cachePath))
+    return false;
+
+  Reader reader(file.data(), file.size());
+
+  if(reader.str() != CATALOG_CACHE_MAGIC ||
+     reader.u32() != CATALOG_CACHE_VERSION ||
+     reader.u64() != d->_dataSize ||
+     reader.u64() != d->_dataTime ||
+     reader.u64() != d->_dataHash ||
+     reader.error())
+    return false;
+
+  vector<string> commands;
+  uint32_t numCommands = reader.u32();
+  for(unsigned int ii = 0; ii < numCommands && !reader.error(); ++ii)
+    commands.push_back(string(reader.str()));
+
+  vector<string> names, queries;
+  uint32_t numCollections = reader.u32();
+  for(unsigned int ii = 0; ii < numCollections && !reader.error(); ++ii)
+  {
+    names.push_back(string(reader.str()));
+    queries.push_back(string(reader.str()));
+  }
+
+  vector<unsigned int> typeIds, deviceIds, familyIds;
+  if(!Private::readDictionary(reader, FacetDictionary::types(), typeIds) ||
+     !Private::readDictionary(reader, FacetDictionary::devices(), deviceIds) ||
+     !Private::readDictionary(reader, FacetDictionary::families(), familyIds))
+    return false;
+
+  vector<uint64_t> keys;
+  uint32_t numGames = reader.u32();
+  for(unsigned int ii = 0; ii < numGames && !reader.error(); ++ii)
+    keys.push_back(reader.u64());
+
+  // The columns are stored with local facet ids
+  string_view table = reader.str();
+  if(reader.error() || !reader.atEnd())
+    return false;
+
+  GameTable loaded;
+  if(!loaded.load(table.data(), table.size()) ||
+     loaded.size() != numGames ||
+     !loaded.remapFacets(typeIds, deviceIds, familyIds))
+    return false;
+
+  std::swap(games, loaded);
+  rowKeys.swap(keys);
+  types.swap(typeIds);
+  devices.swap(deviceIds);
+  families.swap(familyIds);
+  prepareCommands.swap(commands);
+  collectionNames.swap(names);
+  collectionQueries.swap(queries);
+  return true;
+}
+
+bool CatalogCache::save(const GameTable& games,
+                        const vector<uint64_t>& rowKeys,
+                        const vector<unsigned int>& types,
+                        const vector<unsigned int>& devices,
+                        const vector<unsigned int>& families,
+                        const vector<string>& prepareCommands,
+                        const vector<string>& collectionNames,
+                        const vector<string>& collectionQueries) const
+{
+  if(!d->_identified)
+    return false;
+
+  Writer writer;
+  writer.str(CATALOG_CACHE_MAGIC);
+  writer.u32(CATALOG_CACHE_VERSION);
+  writer.u64(d->_dataSize);
+  writer.u64(d->_dataTime);
+  writer.u64(d->_dataHash);
+
+  writer.u32(prepareCommands.size());
+  for(unsigned int ii = 0; ii < prepareCommands.size(); ++ii)
+    writer.str(prepareCommands[ii]);
+
+  writer.u32(collectionNames.size());
+  for(unsigned int ii = 0; ii < collectionNames.size(); ++ii)
+  {
+    writer.str(collectionNames[ii]);
+    writer.str(collectionQueries[ii]);
+  }
+
+  vector<unsigned int> localTypes, localDevices, localFamilies;
+  Private::writeDictionary(writer, FacetDictionary::types(), types, localTypes);
+  Private::writeDictionary(writer, FacetDictionary::devices(), devices, localDevices);
+  Private::writeDictionary(writer, FacetDictionary::families(), families, localFamilies);
+
+  writer.u32(games.size());
+  for(unsigned int ii = 0; ii < games.size(); ++ii)
+    writer.u64(ii < rowKeys.size() ? rowKeys[ii] : 0);
+
+  GameTable local;
+  local.append(games);
+  local.remapFacets(localTypes, localDevices, localFamilies);
+  string table;
+  local.save(table);
+  writer.str(table);
+
+  // Write then rename, so that a reader never sees a partial cache
+  string temporaryPath = d->_cachePath + ".tmp";
+  {
+    ofstream file(temporaryPath.c_str(), ios::out | ios::binary | ios::trunc);
+    if(!file.good())
+      return false;
+    file.write(writer.buffer().data(), writer.buffer().size());
+    if(!file.good())
+      return false;
+  }
+  return rename(temporaryPath.c_str(), d->_cachePath.c_str()) == 0;
+}
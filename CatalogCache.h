@@ -0,0 +1,52 @@
+#ifndef CATALOGCACHE_H
+#define CATALOGCACHE_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+class GameTable;
+
+// Binary image of a loaded catalog (sorted games, facet vectors, PREPARE
+// commands, collections), written next to the CSV file. It is only valid for the CSV
+// file it was built from: size, modification time and content hash are
+// stored in its header.
+class CatalogCache
+{
+  public:
+    CatalogCache(const std::string& cachePath);
+    ~CatalogCache();
+
+    // Identifies the state of the CSV file from its content as read for
+    // parsing, false if the file can't be found
+    bool identify(const std::string& dataPath, const char* data, size_t size);
+
+    // Facet vectors hold FacetDictionary ids, games are sorted. rowKeys
+    // identify the CSV row of each game, for incremental reloads.
+    bool load(GameTable& games,
+              std::vector<uint64_t>& rowKeys,
+              std::vector<unsigned int>& types,
+              std::vector<unsigned int>& devices,
+              std::vector<unsigned int>& families,
+              std::vector<std::string>& prepareCommands,
+              std::vector<std::string>& collectionNames,
+              std::vector<std::string>& collectionQueries) const;
+
+    bool save(const GameTable& games,
+              const std::vector<uint64_t>& rowKeys,
+              const std::vector<unsigned int>& types,
+              const std::vector<unsigned int>& devices,
+              const std::vector<unsigned int>& families,
+              const std::vector<std::string>& prepareCommands,
+              const std::vector<std::string>& collectionNames,
+              const std::vector<std::string>& collectionQueries) const;
+
+  private:
+    CatalogCache(const CatalogCache&);
+    CatalogCache& operator=(const CatalogCache&);
+
+    class Private;
+    Private* d;
+};
+
+#endif // CATALOGCACHE_H
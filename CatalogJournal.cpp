@@ -0,0 +1,528 @@
+#include "CatalogJournal.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+#include <unordered_set>
+#include <sys/stat.h>
+#include "CatalogReader.h"
+#include "MacroExpander.h"
+
+using namespace std;
+
+namespace
+{
+  const char* FieldNames[CatalogJournal::NUM_FIELDS] = {"title", "short", "key", "types", "device", "players", "family", "artwork", "command"};
+
+  bool isGameRow(string_view line)
+  {
+    string_view first = line.substr(0, line.find(';'));
+    return !first.empty() &&
+           first[0] != '#' &&
+           first != "MACRO" &&
+           first != "PREPARE" &&
+           first != "COLLECTION";
+  }
+
+  bool exists(const string& path)
+  {
+    struct stat status;
+    return stat(path.c_str(), &status) == 0;
+  }
+
+  // Neither a sort key nor a device holds ';'
+  void identify(string_view sortKey, string_view device, string& result)
+  {
+    result.assign(sortKey);
+    result += ';';
+    result.append(device);
+  }
+}
+
+class CatalogJournal::Private
+{
+  public:
+    Private(const string& path);
+    ~Private(){}
+
+    void clear();
+    // False if the file exists but can't be read
+    bool read(const string& path);
+    void replay(string_view record);
+    Edit& edit(string_view sortKey, string_view device, Edit::Kind kind);
+    // Edit of the game of a catalog row, NULL if none
+    const Edit* find(const vector<string_view>& fields);
+    bool resolve(const vector<string>& catalogs);
+
+    static bool uses(const Edit& edit, const string& macro);
+
+    static int field(string_view name);
+
+    string _path;
+    // Records being written into the catalog. Read before the journal if a
+    // compaction was stopped halfway: records can be replayed twice.
+    string _compactingPath;
+    vector<Edit> _edits;
+    // Sort key and device -> edit
+    unordered_map<string, unsigned int> _keys;
+    string _identity;
+    unsigned int _numRecords;
+    // Set by resolve(): the macros of all files, the first definition
+    // winning, and the names defined by each file
+    MacroExpander _macros;
+    vector<string> _macroNames;
+    vector<vector<string> > _fileMacros;
+};
+
+CatalogJournal::Private::Private(const string& path):
+  _path(path),
+  _compactingPath(path + ".compacting"),
+  _edits(),
+  _keys(),
+  _identity(),
+  _numRecords(0),
+  _macros(),
+  _macroNames(),
+  _fileMacros()
+{}
+
+void CatalogJournal::Private::clear()
+{
+  _edits.clear();
+  _keys.clear();
+  _numRecords = 0;
+  _macros.clear();
+  _macroNames.clear();
+  _fileMacros.clear();
+}
+
+int CatalogJournal::Private::field(string_view name)
+{
+  for(unsigned int ii = 0; ii < NUM_FIELDS; ++ii)
+  {
+    if(name == FieldNames[ii])
+      return ii;
+  }
+  return -1;
+}
+
+CatalogJournal::Edit& CatalogJournal::Private::edit(string_view sortKey, string_view device, Edit::Kind kind)
+{
+  identify(sortKey, device, _identity);
+  unordered_map<string, unsigned int>::const_iterator found = _keys.find(_identity);
+  if(found == _keys.end())
+  {
+    found = _keys.insert(make_pair(_identity, (unsigned int) _edits.size())).first;
+    _edits.push_back(Edit());
+  }
+
+  Edit& res = _edits[found->second];
+  res.kind = kind;
+  res.sortKey = string(sortKey);
+  res.device = string(device);
+  res.fields.assign(NUM_FIELDS, string());
+  res.changed.assign(NUM_FIELDS, false);
+  res.ignored = false;
+  return res;
+}
+
+const CatalogJournal::Edit* CatalogJournal::Private::find(const vector<string_view>& fields)
+{
+  identify(sortKey(fields), device(fields), _identity);
+  unordered_map<string, unsigned int>::const_iterator found = _keys.find(_identity);
+  return found == _keys.end() ? NULL : &_edits[found->second];
+}
+
+void CatalogJournal::Private::replay(string_view record)
+{
+  if(record.empty() || record[0] == '#')
+    return;
+  if(record[record.size() - 1] == '\r')
+    record.remove_suffix(1);
+
+  string_view type = record.substr(0, record.find(';'));
+  string_view rest = type.size() < record.size() ? record.substr(type.size() + 1) : string_view();
+  vector<string_view> split;
+  if(type == "ADD")
+  {
+    CatalogReader::split(rest, ';', split);
+    string_view key = sortKey(split);
+    if(key.empty())
+      return;
+    Edit& added = edit(key, device(split), Edit::ADDED);
+    for(unsigned int ii = 0; ii < split.size() && ii < NUM_FIELDS; ++ii)
+      added.fields[ii] = string(split[ii]);
+    added.changed.assign(NUM_FIELDS, true);
+  }
+  else if(type == "REMOVE")
+  {
+    CatalogReader::split(rest, ';', split);
+    if(split.size() != 2 || split[0].empty())
+      return;
+    edit(split[0], split[1], Edit::REMOVED);
+  }
+  else if(type == "SET")
+  {
+    CatalogReader::split(rest, ';', split);
+    int index = split.size() == 4 ? field(split[2]) : -1;
+    // The sort key and the device designate the game: changing them is
+    // removing it and adding another
+    if(index < 0 || index == SORT_KEY || index == DEVICE || split[0].empty())
+      return;
+
+    identify(split[0], split[1], _identity);
+    unordered_map<string, unsigned int>::const_iterator found = _keys.find(_identity);
+    Edit* changed(NULL);
+    if(found == _keys.end())
+      changed = &edit(split[0], split[1], Edit::CHANGED);
+    else if(_edits[found->second].kind != Edit::REMOVED)
+      changed = &_edits[found->second];
+    else
+      return;
+
+    changed->fields[index] = string(split[3]);
+    changed->changed[index] = true;
+  }
+  else
+  {
+    return;
+  }
+  ++_numRecords;
+}
+
+bool CatalogJournal::Private::read(const string& path)
+{
+  CatalogReader reader;
+  if(!reader.open(path, true))
+    return !exists(path);
+
+  string_view line;
+  while(reader.nextLine(line))
+    replay(line);
+  return true;
+}
+
+CatalogJournal::CatalogJournal(const string& path):
+  d(new Private(path))
+{}
+
+CatalogJournal::~CatalogJournal()
+{
+  delete d;
+}
+
+const string& CatalogJournal::path() const
+{
+  return d->_path;
+}
+
+string_view CatalogJournal::sortKey(const vector<string_view>& fields)
+{
+  // As GameTable::addGame(): an empty sort key is the name
+  if(fields.size() > SORT_KEY && !fields[SORT_KEY].empty())
+    return fields[SORT_KEY];
+  return fields.empty() ? string_view() : fields[TITLE];
+}
+
+string_view CatalogJournal::device(const vector<string_view>& fields)
+{
+  return fields.size() > DEVICE ? fields[DEVICE] : string_view();
+}
+
+bool CatalogJournal::load()
+{
+  d->clear();
+  if(d->_path.empty())
+    return true;
+  return d->read(d->_compactingPath) && d->read(d->_path);
+}
+
+unsigned int CatalogJournal::numRecords() const
+{
+  return d->_numRecords;
+}
+
+const vector<CatalogJournal::Edit>& CatalogJournal::edits() const
+{
+  return d->_edits;
+}
+
+bool CatalogJournal::resolve(const vector<string>& catalogs)
+{
+  return d->resolve(catalogs);
+}
+
+const MacroExpander& CatalogJournal::macros() const
+{
+  return d->_macros;
+}
+
+bool CatalogJournal::Private::uses(const Edit& edit, const string& macro)
+{
+  // Only paths are expanded
+  return (edit.changed[ARTWORK] && edit.fields[ARTWORK].find(macro) != string::npos) ||
+         (edit.changed[COMMAND] && edit.fields[COMMAND].find(macro) != string::npos);
+}
+
+bool CatalogJournal::Private::resolve(const vector<string>& catalogs)
+{
+  _macros.clear();
+  _macroNames.clear();
+  _fileMacros.assign(catalogs.size(), vector<string>());
+
+  // Games of each edit, whatever the file they are in, and the file and
+  // line of the last one
+  vector<unsigned int> numGames(_edits.size(), 0);
+  vector<unsigned int> gameFiles(_edits.size(), 0);
+  vector<unsigned int> gameLines(_edits.size(), 0);
+  // Macros of each file on their own, and the line of their first
+  // definition, as the file expands its rows with them
+  vector<MacroExpander> fileMacros(catalogs.size());
+  vector<unordered_map<string, unsigned int> > definitions(catalogs.size());
+  bool res(true);
+  vector<string_view> split;
+  for(unsigned int ii = 0; ii < catalogs.size(); ++ii)
+  {
+    CatalogReader reader;
+    if(!reader.open(catalogs[ii], true))
+    {
+      res = false;
+      continue;
+    }
+
+    string_view line;
+    for(unsigned int number = 0; reader.nextLine(line); ++number)
+    {
+      if(!line.empty() && line[line.size() - 1] == '\r')
+        line.remove_suffix(1);
+      CatalogReader::split(line, ';', split);
+      if(!split.empty() && split[0] == "MACRO" && split.size() > 2)
+      {
+        _fileMacros[ii].push_back(string(split[1]));
+        _macroNames.push_back(string(split[1]));
+        _macros.define(split[1], split[2]);
+        fileMacros[ii].define(split[1], split[2]);
+        definitions[ii].insert(make_pair(string(split[1]), number));
+        continue;
+      }
+
+      const Edit* found(NULL);
+      if(isGameRow(line))
+        found = find(split);
+      if(found == NULL)
+        continue;
+      unsigned int edit = found - &_edits[0];
+      ++numGames[edit];
+      gameFiles[edit] = ii;
+      gameLines[edit] = number;
+    }
+  } // end for(unsigned int ii = 0; ii < catalogs.size(); ++ii)
+
+  // Macros some file expands differently from the others
+  unordered_set<string> ambiguous;
+  string value, fileValue;
+  for(unsigned int macro = 0; macro < _macroNames.size(); ++macro)
+  {
+    const string& name = _macroNames[macro];
+    _macros.expand(name, value);
+    for(unsigned int ii = 0; ii < catalogs.size(); ++ii)
+    {
+      if(definitions[ii].find(name) == definitions[ii].end())
+        continue;
+      fileMacros[ii].expand(name, fileValue);
+      if(fileValue != value)
+        ambiguous.insert(name);
+    }
+  } // end for(unsigned int macro = 0; macro < _macroNames.size(); ++macro)
+
+  // The catalog rows written by compact() must read as the edits were
+  // replayed: with the same macros, defined above them
+  for(unsigned int ii = 0; ii < _edits.size(); ++ii)
+  {
+    Edit& edit = _edits[ii];
+    edit.ignored = numGames[ii] > 1;
+    for(unsigned int macro = 0; macro < _macroNames.size() && !edit.ignored; ++macro)
+    {
+      const string& name = _macroNames[macro];
+      if(!uses(edit, name))
+        continue;
+      if(ambiguous.find(name) != ambiguous.end())
+      {
+        edit.ignored = true;
+      }
+      else if(edit.kind == Edit::CHANGED && numGames[ii] == 1)
+      {
+        const unordered_map<string, unsigned int>& defined = definitions[gameFiles[ii]];
+        unordered_map<string, unsigned int>::const_iterator found = defined.find(name);
+        edit.ignored = found != defined.end() && found->second > gameLines[ii];
+      }
+    }
+  } // end for(unsigned int ii = 0; ii < _edits.size(); ++ii)
+  return res;
+}
+
+bool CatalogJournal::compact(const vector<string>& catalogs)
+{
+  if(d->_path.empty() || catalogs.empty())
+    return false;
+
+  // Records appended from now on go to a new journal. Those of a compaction
+  // stopped halfway are written again with the others.
+  if(exists(d->_path))
+  {
+    if(!exists(d->_compactingPath))
+    {
+      if(rename(d->_path.c_str(), d->_compactingPath.c_str()) != 0)
+        return false;
+    }
+    else
+    {
+      CatalogReader journal;
+      FILE* output = fopen(d->_compactingPath.c_str(), "a");
+      bool moved = output != NULL && journal.open(d->_path, true) &&
+                   fwrite(journal.data(), 1, journal.size(), output) == journal.size();
+      if(output != NULL && fclose(output) != 0)
+        moved = false;
+      if(!moved || ::remove(d->_path.c_str()) != 0)
+        return false;
+    }
+  }
+
+  d->clear();
+  if(!d->read(d->_compactingPath) || !d->resolve(catalogs))
+    return false;
+  const vector<vector<string> >& macros = d->_fileMacros;
+  const vector<string>& macroNames = d->_macroNames;
+
+  // Rows of the games edited are changed in place, or left out
+  vector<string> contents(catalogs.size());
+  vector<bool> edited(catalogs.size(), false);
+  // Text written from the records into each file
+  vector<string> recorded(catalogs.size());
+  vector<string_view> split;
+  for(unsigned int ii = 0; ii < catalogs.size(); ++ii)
+  {
+    CatalogReader reader;
+    if(!reader.open(catalogs[ii], true))
+      return false;
+
+    string& content = contents[ii];
+    content.reserve(reader.size());
+    string_view line;
+    while(reader.nextLine(line))
+    {
+      string_view end;
+      if(!line.empty() && line[line.size() - 1] == '\r')
+      {
+        end = line.substr(line.size() - 1);
+        line.remove_suffix(1);
+      }
+
+      CatalogReader::split(line, ';', split);
+      const Edit* found(NULL);
+      if(isGameRow(line))
+        found = d->find(split);
+      if(found == NULL || found->ignored)
+      {
+        content.append(line);
+        content.append(end);
+        content += '\n';
+        continue;
+      }
+
+      edited[ii] = true;
+      const Edit& edit = *found;
+      if(edit.kind != Edit::CHANGED)
+        continue;
+
+      for(unsigned int field = 0; field < NUM_FIELDS || field < split.size(); ++field)
+      {
+        if(field > 0)
+          content += ';';
+        if(field < NUM_FIELDS && edit.changed[field])
+        {
+          content.append(edit.fields[field]);
+          recorded[ii] += edit.fields[field];
+        }
+        else if(field == SORT_KEY && edit.changed[TITLE])
+        {
+          // A game keyed by its title keeps its key
+          content.append(edit.sortKey);
+        }
+        else if(field < split.size())
+          content.append(split[field]);
+      }
+      content.append(end);
+      content += '\n';
+    } // end while(reader.nextLine(line))
+  } // end for(unsigned int ii = 0; ii < catalogs.size(); ++ii)
+
+  for(unsigned int ii = 0; ii < d->_edits.size(); ++ii)
+  {
+    const Edit& edit = d->_edits[ii];
+    if(edit.kind != Edit::ADDED || edit.ignored)
+      continue;
+
+    unsigned int target(0);
+    bool found(false);
+    for(unsigned int catalog = 0; catalog < catalogs.size() && !found; ++catalog)
+    {
+      for(unsigned int macro = 0; macro < macros[catalog].size() && !found; ++macro)
+      {
+        found = edit.fields[ARTWORK].find(macros[catalog][macro]) != string::npos ||
+                edit.fields[COMMAND].find(macros[catalog][macro]) != string::npos;
+        if(found)
+          target = catalog;
+      }
+    }
+
+    string& content = contents[target];
+    if(!content.empty() && content[content.size() - 1] != '\n')
+      content += '\n';
+    for(unsigned int field = 0; field < NUM_FIELDS; ++field)
+    {
+      if(field > 0)
+        content += ';';
+      content.append(edit.fields[field]);
+      recorded[target] += edit.fields[field];
+    }
+    content += '\n';
+    edited[target] = true;
+  } // end for(unsigned int ii = 0; ii < d->_edits.size(); ++ii)
+
+  // Each file is written aside, then renamed
+  string value;
+  for(unsigned int ii = 0; ii < catalogs.size(); ++ii)
+  {
+    if(!edited[ii])
+      continue;
+
+    // Macros of other files used by the records are defined on top
+    string missing;
+    for(unsigned int macro = 0; macro < macroNames.size(); ++macro)
+    {
+      const string& name = macroNames[macro];
+      if(recorded[ii].find(name) == string::npos ||
+         std::find(macros[ii].begin(), macros[ii].end(), name) != macros[ii].end() ||
+         missing.find("MACRO;" + name + ';') != string::npos)
+        continue;
+      d->_macros.expand(name, value);
+      missing += "MACRO;" + name + ';' + value + '\n';
+    }
+    contents[ii].insert(0, missing);
+
+    string temporary = catalogs[ii] + ".tmp";
+    FILE* output = fopen(temporary.c_str(), "wb");
+    if(output == NULL)
+      return false;
+    bool written = fwrite(contents[ii].data(), 1, contents[ii].size(), output) == contents[ii].size();
+    if(fclose(output) != 0 || !written || rename(temporary.c_str(), catalogs[ii].c_str()) != 0)
+    {
+      ::remove(temporary.c_str());
+      return false;
+    }
+  } // end for(unsigned int ii = 0; ii < catalogs.size(); ++ii)
+
+  d->clear();
+  return ::remove(d->_compactingPath.c_str()) == 0;
+}
@@ -0,0 +1,104 @@
+#ifndef CATALOGJOURNAL_H
+#define CATALOGJOURNAL_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+class MacroExpander;
+
+// Edits of the catalog appended by hand to a journal file next to it, so
+// that adding, hiding or changing a game does not rewrite the catalog. One
+// record per line, lines starting with '#' being comments:
+//   ADD;<game row, as in the catalog>
+//   REMOVE;<sort key>;<device>
+//   SET;<sort key>;<device>;<field>;<value>
+// A game is designated by its sort key, or its title when it is empty, and
+// its device: a title is often shared by several systems. ADD replaces the
+// game of the same key and device, REMOVE hides it, SET changes one of its
+// fields: title, short, types, players, family, artwork or command. A
+// record designating more than one game of the catalog is ignored.
+//
+// Values are expanded with the macros of all catalog files. A record using
+// a macro that the files define with different values, or, for SET, that
+// the file of the game defines below it, is ignored: the catalog would not
+// read the same once the record is written into it.
+//
+// Content::init() replays the records over the catalog, and writes them into
+// the catalog with compact() once there are many.
+class CatalogJournal
+{
+  public:
+    enum Field
+    {
+      TITLE,
+      SHORT_TITLE,
+      SORT_KEY,
+      TYPES,
+      DEVICE,
+      PLAYERS,
+      FAMILY,
+      ARTWORK,
+      COMMAND,
+      NUM_FIELDS
+    };
+
+    // Outcome of the records of one game
+    struct Edit
+    {
+      enum Kind
+      {
+        ADDED,
+        REMOVED,
+        CHANGED
+      };
+
+      Kind kind;
+      std::string sortKey;
+      std::string device;
+      // Catalog fields of the game added, or the fields set on the games of
+      // the catalog, the others being empty
+      std::vector<std::string> fields;
+      std::vector<bool> changed;
+      // Designates more than one game or uses ambiguous macros, see
+      // resolve()
+      bool ignored;
+    };
+
+    CatalogJournal(const std::string& path);
+    ~CatalogJournal();
+
+    const std::string& path() const;
+
+    // Reads the records again, false if the journal can't be read. No
+    // journal is an empty one.
+    bool load();
+    unsigned int numRecords() const;
+    // One edit per game, in the order the games first appear
+    const std::vector<Edit>& edits() const;
+    // Reads the macros of the catalog files, and marks the edits
+    // designating more than one game of the files, or using ambiguous
+    // macros, as ignored. False if a file can't be read.
+    bool resolve(const std::vector<std::string>& catalogs);
+    // Macros of the files given to resolve(), to expand the values with
+    const MacroExpander& macros() const;
+
+    // Writes the records into the catalog files, then empties the journal.
+    // Ignored edits are dropped.
+    // Added games go to the first file defining the macros they use, and
+    // macros used by a record but defined in another file are copied.
+    bool compact(const std::vector<std::string>& catalogs);
+
+    // Sort key and device of a catalog row, given its fields
+    static std::string_view sortKey(const std::vector<std::string_view>& fields);
+    static std::string_view device(const std::vector<std::string_view>& fields);
+
+  private:
+    CatalogJournal(const CatalogJournal&);
+    CatalogJournal& operator=(const CatalogJournal&);
+
+    class Private;
+    Private* d;
+};
+
+#endif // CATALOGJOURNAL_H
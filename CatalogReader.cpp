@@ -0,0 +1,217 @@
+#include "CatalogReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#ifndef WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+class CatalogReader::Private
+{
+  public:
+    Private();
+    ~Private(){}
+
+    const char* _data;
+    size_t _size;
+    size_t _offset;
+    string _buffer;
+#ifndef WIN32
+    bool _isMapped;
+#endif
+
+    bool read(const string& path);
+};
+
+CatalogReader::Private::Private():
+  _data(NULL),
+  _size(0),
+  _offset(0),
+  _buffer()
+#ifndef WIN32
+  , _isMapped(false)
+#endif
+{}
+
+bool CatalogReader::Private::read(const string& path)
+{
+  ifstream file(path.c_str(), ios::in | ios::binary);
+  if(!file.good())
+    return false;
+  _buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+  _data = _buffer.data();
+  _size = _buffer.size();
+  return true;
+}
+
+CatalogReader::CatalogReader():
+  d(new Private)
+{}
+
+CatalogReader::~CatalogReader()
+{
+  close();
+  delete d;
+}
+
+bool CatalogReader::open(const string& path, bool copy)
+{
+  close();
+
+#ifdef WIN32
+  copy = true;
+#endif
+  if(copy)
+  {
+    d->_offset = 0;
+    return d->read(path);
+  }
+
+#ifndef WIN32
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0)
+    return false;
+
+  struct stat info;
+  if(fstat(fd, &info) != 0)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  d->_size = info.st_size;
+  if(d->_size != 0)
+  {
+    void* mapping = mmap(NULL, d->_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(mapping == MAP_FAILED)
+    {
+      ::close(fd);
+      d->_size = 0;
+      return false;
+    }
+    madvise(mapping, d->_size, MADV_SEQUENTIAL);
+    d->_data = static_cast<const char*>(mapping);
+    d->_isMapped = true;
+  }
+  else
+  {
+    d->_data = "";
+  }
+  // The mapping stays valid once the descriptor is closed
+  ::close(fd);
+#endif
+
+  d->_offset = 0;
+  return true;
+}
+
+void CatalogReader::close()
+{
+  d->_buffer.clear();
+#ifndef WIN32
+  if(d->_isMapped)
+    munmap(const_cast<char*>(d->_data), d->_size);
+  d->_isMapped = false;
+#endif
+  d->_data = NULL;
+  d->_size = 0;
+  d->_offset = 0;
+}
+
+bool CatalogReader::isOpen() const
+{
+  return d->_data != NULL;
+}
+
+const char* CatalogReader::data() const
+{
+  return d->_data;
+}
+
+size_t CatalogReader::size() const
+{
+  return d->_size;
+}
+
+bool CatalogReader::nextLine(string_view& line)
+{
+  if(d->_data == NULL || d->_offset >= d->_size)
+    return false;
+
+  const char* begin = d->_data + d->_offset;
+  const char* end = static_cast<const char*>(memchr(begin, '\n', d->_size - d->_offset));
+  if(end == NULL)
+  {
+    line = string_view(begin, d->_size - d->_offset);
+    d->_offset = d->_size;
+  }
+  else
+  {
+    line = string_view(begin, end - begin);
+    d->_offset += line.size() + 1;
+  }
+  return true;
+}
+
+void CatalogReader::rewind()
+{
+  d->_offset = 0;
+}
+
+void CatalogReader::split(string_view str, const char sep, vector<string_view>& fields)
+{
+  fields.clear();
+
+  if(str.empty())
+    return;
+
+  size_t start(0);
+  size_t pos = str.find(sep);
+  while(pos != string_view::npos)
+  {
+    fields.push_back(str.substr(start, pos - start));
+    start = pos + 1;
+    pos = str.find(sep, start);
+  }
+  fields.push_back(str.substr(start));
+}
+
+bool CatalogReader::list(const string& directory, const string& extension, vector<string>& paths)
+{
+  paths.clear();
+
+#ifdef WIN32
+  return false;
+#else
+  DIR* dir = opendir(directory.c_str());
+  if(dir == NULL)
+    return false;
+
+  string prefix(directory);
+  if(!prefix.empty() && prefix[prefix.size() - 1] != '/')
+    prefix += '/';
+
+  struct dirent* entry;
+  while((entry = readdir(dir)) != NULL)
+  {
+    string name(entry->d_name);
+    if(name.size() > extension.size() &&
+       name[0] != '.' &&
+       name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+    {
+      paths.push_back(prefix + name);
+    }
+  }
+  closedir(dir);
+
+  std::sort(paths.begin(), paths.end());
+  return true;
+#endif
+}
@@ -0,0 +1,45 @@
+#ifndef CATALOGREADER_H
+#define CATALOGREADER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Read-only view of the catalog file, memory-mapped where available.
+// Lines and fields are returned as views into the mapping: nothing is
+// copied, and lines have no length limit.
+class CatalogReader
+{
+  public:
+    CatalogReader();
+    ~CatalogReader();
+
+    // copy reads the file into memory instead of mapping it, for a file that
+    // may be rewritten while it is parsed
+    bool open(const std::string& path, bool copy = false);
+    void close();
+    bool isOpen() const;
+
+    const char* data() const;
+    size_t size() const;
+
+    // Next line without its '\n', false at end of file
+    bool nextLine(std::string_view& line);
+    void rewind();
+
+    // Fields between separators, empty when the string is empty
+    static void split(std::string_view str, const char sep, std::vector<std::string_view>& fields);
+
+    // Paths of the files of a directory whose name ends with extension,
+    // sorted, false if the directory can't be read
+    static bool list(const std::string& directory, const std::string& extension, std::vector<std::string>& paths);
+
+  private:
+    CatalogReader(const CatalogReader&);
+    CatalogReader& operator=(const CatalogReader&);
+
+    class Private;
+    Private* d;
+};
+
+#endif // CATALOGREADER_H
@@ -0,0 +1,120 @@
+#include "CatalogWatcher.h"
+
+#ifndef WIN32
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+class CatalogWatcher::Private
+{
+  public:
+    Private();
+    ~Private(){}
+
+    bool matches(const string& name) const;
+
+    int _fd;
+    string _fileName;
+    string _otherName;
+};
+
+CatalogWatcher::Private::Private():
+  _fd(-1),
+  _fileName(),
+  _otherName()
+{}
+
+bool CatalogWatcher::Private::matches(const string& name) const
+{
+  if(!_otherName.empty() && name == _otherName)
+    return true;
+  if(!_fileName.empty())
+    return name == _fileName;
+  return name.size() > 4 && name.compare(name.size() - 4, 4, ".csv") == 0;
+}
+
+CatalogWatcher::CatalogWatcher():
+  d(new Private)
+{}
+
+CatalogWatcher::~CatalogWatcher()
+{
+  stop();
+  delete d;
+}
+
+bool CatalogWatcher::watch(const string& path, const string& other)
+{
+  stop();
+
+#ifdef WIN32
+  return false;
+#else
+  // The directory is watched: saving often replaces the file itself
+  string directory(".");
+  d->_fileName = path;
+  size_t separator = path.rfind('/');
+  if(separator != string::npos)
+  {
+    directory = path.substr(0, separator + 1);
+    d->_fileName = path.substr(separator + 1);
+  }
+  size_t otherSeparator = other.rfind('/');
+  string otherDirectory = otherSeparator != string::npos ? other.substr(0, otherSeparator + 1) : string(".");
+  d->_otherName.clear();
+  if(!other.empty() && otherDirectory == directory)
+    d->_otherName = other.substr(otherSeparator + 1);
+
+  d->_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if(d->_fd < 0)
+    return false;
+
+  if(inotify_add_watch(d->_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+  {
+    stop();
+    return false;
+  }
+  return true;
+#endif
+}
+
+void CatalogWatcher::stop()
+{
+#ifndef WIN32
+  if(d->_fd >= 0)
+    close(d->_fd);
+#endif
+  d->_fd = -1;
+}
+
+bool CatalogWatcher::waitForChange(int timeout)
+{
+#ifdef WIN32
+  return false;
+#else
+  if(d->_fd < 0)
+    return false;
+
+  struct pollfd descriptor;
+  descriptor.fd = d->_fd;
+  descriptor.events = POLLIN;
+  descriptor.revents = 0;
+  if(poll(&descriptor, 1, timeout) <= 0)
+    return false;
+
+  bool changed(false);
+  char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  ssize_t length = read(d->_fd, buffer, sizeof(buffer));
+  for(char* ptr = buffer; length > 0 && ptr < buffer + length; )
+  {
+    const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+    if(event->len > 0 && d->matches(event->name))
+      changed = true;
+    ptr += sizeof(struct inotify_event) + event->len;
+  }
+  return changed;
+#endif
+}
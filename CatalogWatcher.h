@@ -0,0 +1,30 @@
+#ifndef CATALOGWATCHER_H
+#define CATALOGWATCHER_H
+
+#include <string>
+
+// Reports writes to a file, including editors that save by replacing it.
+// Only implemented with inotify: elsewhere no change is ever reported.
+class CatalogWatcher
+{
+  public:
+    CatalogWatcher();
+    ~CatalogWatcher();
+
+    // A path ending with '/' watches the .csv files of that directory. other
+    // is a file of the same directory watched as well, such as the journal.
+    bool watch(const std::string& path, const std::string& other = std::string());
+    void stop();
+
+    // Waits up to timeout milliseconds, true if the file changed meanwhile
+    bool waitForChange(int timeout);
+
+  private:
+    CatalogWatcher(const CatalogWatcher&);
+    CatalogWatcher& operator=(const CatalogWatcher&);
+
+    class Private;
+    Private* d;
+};
+
+#endif // CATALOGWATCHER_H
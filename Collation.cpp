@@ -0,0 +1,137 @@
+#include "Collation.h"
+
+#include <cstring>
+#include "Content.h"
+
+using namespace std;
+
+// Below this, buckets are sorted by insertion
+#define MIN_RADIX_BUCKET 32
+
+namespace
+{
+  // Base letters of U+00C0 to U+00FF, NULL when the character is kept
+  const char* latin1[64] = {
+    "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    "d", "n", "o", "o", "o", "o", "o", NULL, "o", "u", "u", "u", "u", "y", "th", "ss",
+    "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    "d", "n", "o", "o", "o", "o", "o", NULL, "o", "u", "u", "u", "u", "y", "th", "y"
+  };
+
+  const char* articles[] = {"the ", "a ", "an ", "le ", "la ", "les ", "l'", NULL};
+
+  // Byte of key at depth, 0 past its end: shorter keys come first
+  inline unsigned int byteAt(string_view key, unsigned int depth)
+  {
+    return depth < key.size() ? (unsigned char) key[depth] + 1 : 0;
+  }
+}
+
+void Collation::normalize(string_view str, string& result)
+{
+  for(unsigned int ii = 0; ii < str.size(); ++ii)
+  {
+    unsigned char c = str[ii];
+    if(c >= 'A' && c <= 'Z')
+    {
+      result += (char) (c - 'A' + 'a');
+    }
+    else if(c == 0xC3 && ii + 1 < str.size() &&
+            (unsigned char) str[ii + 1] >= 0x80 && (unsigned char) str[ii + 1] <= 0xBF &&
+            latin1[(unsigned char) str[ii + 1] - 0x80] != NULL)
+    {
+      result += latin1[(unsigned char) str[ii + 1] - 0x80];
+      ++ii;
+    }
+    else
+    {
+      result += (char) c;
+    }
+  } // end for(unsigned int ii = 0; ii < str.size(); ++ii)
+}
+
+string_view Collation::stripArticle(string_view normalized)
+{
+  for(unsigned int ii = 0; articles[ii] != NULL; ++ii)
+  {
+    size_t length = strlen(articles[ii]);
+    if(normalized.size() > length && normalized.compare(0, length, articles[ii]) == 0)
+      return normalized.substr(length);
+  }
+  return normalized;
+}
+
+void Collation::key(const Game& game, string& result)
+{
+  result.clear();
+  normalize(game.getSortKey(), result);
+  result.erase(0, result.size() - stripArticle(result).size());
+
+  // Catalog text holds no '\0': it ends each part before the next one
+  result += '\0';
+  result.append(game.getSortKey());
+  result += '\0';
+  result.append(game.getName());
+  result += '\0';
+  result.append(game.getShortName());
+  result += '\0';
+  result.append(game.getDevice());
+}
+
+void Collation::sort(const vector<string_view>& keys, vector<unsigned int>& indices)
+{
+  vector<unsigned int> buffer(indices.size());
+  sort(keys, indices.data(), buffer.data(), indices.size(), 0);
+}
+
+void Collation::sort(const vector<string_view>& keys,
+                     unsigned int* indices,
+                     unsigned int* buffer,
+                     unsigned int count,
+                     unsigned int depth)
+{
+  if(count < MIN_RADIX_BUCKET)
+  {
+    for(unsigned int ii = 1; ii < count; ++ii)
+    {
+      unsigned int index = indices[ii];
+      string_view key = keys[index].substr(depth < keys[index].size() ? depth : keys[index].size());
+      unsigned int jj = ii;
+      while(jj > 0)
+      {
+        string_view other = keys[indices[jj - 1]];
+        other = other.substr(depth < other.size() ? depth : other.size());
+        if(!(key < other))
+          break;
+        indices[jj] = indices[jj - 1];
+        --jj;
+      }
+      indices[jj] = index;
+    }
+    return;
+  }
+
+  // Most significant byte first: indices are distributed by their byte at
+  // depth, then each bucket is sorted on the next bytes
+  unsigned int counts[258];
+  memset(counts, 0, sizeof(counts));
+  for(unsigned int ii = 0; ii < count; ++ii)
+    ++counts[byteAt(keys[indices[ii]], depth) + 1];
+  for(unsigned int ii = 1; ii < 258; ++ii)
+    counts[ii] += counts[ii - 1];
+
+  // Stable distribution
+  for(unsigned int ii = 0; ii < count; ++ii)
+    buffer[counts[byteAt(keys[indices[ii]], depth)]++] = indices[ii];
+  memcpy(indices, buffer, count * sizeof(unsigned int));
+
+  // counts[b] is now the end of bucket b. Keys ending at depth are
+  // complete and equal: they are left in place.
+  for(unsigned int bucket = 1; bucket < 257; ++bucket)
+  {
+    unsigned int first = counts[bucket - 1];
+    unsigned int size = counts[bucket] - first;
+    if(size > 1)
+      sort(keys, indices + first, buffer, size, depth + 1);
+  }
+}
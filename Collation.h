@@ -0,0 +1,37 @@
+#ifndef COLLATION_H
+#define COLLATION_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Game;
+
+// Catalog order. Each game gets a binary key, and games are ordered by
+// comparing keys byte per byte: the sort key without case, accents and
+// leading article, then sort key, name, short name and device as they are.
+class Collation
+{
+  public:
+    // Appends str folded to lower case, without accents (UTF-8 Latin-1)
+    static void normalize(std::string_view str, std::string& result);
+
+    // Normalized str without its leading article, if any
+    static std::string_view stripArticle(std::string_view normalized);
+
+    // Replaces the content of result
+    static void key(const Game& game, std::string& result);
+
+    // Reorders indices by the keys they designate, equal keys keeping their
+    // relative order
+    static void sort(const std::vector<std::string_view>& keys, std::vector<unsigned int>& indices);
+
+  private:
+    static void sort(const std::vector<std::string_view>& keys,
+                     unsigned int* indices,
+                     unsigned int* buffer,
+                     unsigned int count,
+                     unsigned int depth);
+};
+
+#endif // COLLATION_H
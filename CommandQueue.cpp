@@ -0,0 +1,102 @@
+#include "CommandQueue.h"
+
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+class CommandQueue::Private
+{
+  public:
+    Private();
+    ~Private(){}
+
+    void work();
+
+    thread _thread;
+    mutex _lock;
+    condition_variable _queued;
+    condition_variable _done;
+    deque<string> _commands;
+    bool _busy;
+    bool _stopping;
+};
+
+CommandQueue::Private::Private():
+  _thread(),
+  _lock(),
+  _queued(),
+  _done(),
+  _commands(),
+  _busy(false),
+  _stopping(false)
+{}
+
+void CommandQueue::Private::work()
+{
+  unique_lock<mutex> lock(_lock);
+  while(true)
+  {
+    while(!_stopping && _commands.empty())
+      _queued.wait(lock);
+    if(_commands.empty())
+      return;
+
+    string command;
+    command.swap(_commands.front());
+    _commands.pop_front();
+    _busy = true;
+
+    lock.unlock();
+    system(command.c_str());
+    lock.lock();
+
+    _busy = false;
+    if(_commands.empty())
+      _done.notify_all();
+  } // end while(true)
+}
+
+CommandQueue::CommandQueue():
+  d(new Private)
+{}
+
+CommandQueue::~CommandQueue()
+{
+  {
+    lock_guard<mutex> lock(d->_lock);
+    d->_stopping = true;
+  }
+  d->_queued.notify_all();
+  if(d->_thread.joinable())
+    d->_thread.join();
+  delete d;
+}
+
+void CommandQueue::run(const string& command)
+{
+  {
+    lock_guard<mutex> lock(d->_lock);
+    d->_commands.push_back(command);
+    // Started with the first command
+    if(!d->_thread.joinable())
+      d->_thread = thread(&CommandQueue::Private::work, d);
+  }
+  d->_queued.notify_one();
+}
+
+void CommandQueue::wait()
+{
+  unique_lock<mutex> lock(d->_lock);
+  while(d->_busy || !d->_commands.empty())
+    d->_done.wait(lock);
+}
+
+CommandQueue& CommandQueue::prepare()
+{
+  static CommandQueue queue;
+  return queue;
+}
@@ -0,0 +1,30 @@
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <string>
+
+// Runs shell commands on a thread of its own, one after the other in the
+// order they were queued.
+class CommandQueue
+{
+  public:
+    CommandQueue();
+    // Runs the commands still queued first
+    ~CommandQueue();
+
+    void run(const std::string& command);
+    // Returns once every command queued so far has run
+    void wait();
+
+    // PREPARE lines of the catalog
+    static CommandQueue& prepare();
+
+  private:
+    CommandQueue(const CommandQueue&);
+    CommandQueue& operator=(const CommandQueue&);
+
+    class Private;
+    Private* d;
+};
+
+#endif // COMMANDQUEUE_H
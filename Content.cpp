@@ -2,190 +2,103 @@
 
 #include <iostream>
 #include <algorithm>
-#include <fstream>
-#include "PixBox.h"
+#include <charconv>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "CatalogCache.h"
+#include "CatalogJournal.h"
+#include "CatalogReader.h"
+#include "CatalogWatcher.h"
+#include "Collation.h"
+#include "CommandQueue.h"
+#include "FacetDictionary.h"
+#include "FacetIndex.h"
+#include "FilterQuery.h"
+#include "FuzzyMatcher.h"
+#include "MacroExpander.h"
+#include "NameIndex.h"
+#include "Selection.h"
 
 using namespace std;
 
-class Game::Private
-{
-  public:
-    Private();
-    Private(const Private& other);
-    Private& operator=(const Private& other);
-    ~Private(){}
-
-    string _name;
-    string _shortName;
-    string _sortKey;
-    list<string> _gameTypes;
-    string _device;
-    unsigned int _maxPlayers;
-    list<string> _gameFamily;
-    string _commandLine;
-    string _picturePath;
-    unsigned int _position;
-};
-
-Game::Private::Private():
-  _name(),
-  _shortName(),
-  _sortKey(),
-  _gameTypes(),
-  _device(),
-  _maxPlayers(1),
-  _gameFamily(),
-  _commandLine(),
-  _picturePath(),
-  _position(0)
-{}
-
-Game::Private::Private(const Game::Private &other):
-  _name(other._name),
-  _shortName(other._shortName),
-  _sortKey(other._sortKey),
-  _gameTypes(other._gameTypes),
-  _device(other._device),
-  _maxPlayers(other._maxPlayers),
-  _gameFamily(other._gameFamily),
-  _commandLine(other._commandLine),
-  _picturePath(other._picturePath),
-  _position(other._position)
-{}
-
-Game::Private& Game::Private::operator =(const Game::Private& other)
-{
-  if(&other == this)
-    return *this;
-
-  _name = other._name;
-  _shortName = other._shortName;
-  _sortKey = other._sortKey;
-  _gameTypes = other._gameTypes;
-  _device = other._device;
-  _maxPlayers = other._maxPlayers;
-  _gameFamily = other._gameFamily;
-  _commandLine = other._commandLine;
-  _picturePath = other._picturePath;
-  _position = other._position;
-
-  return *this;
-}
-
-
-
-
-
-
-
-
+bool IsQuiet(true);
 
+// Below this, loading threads cost more than they save
+#define MIN_ROWS_PER_CHUNK 1024
+// Shorter search texts finding no name are not retried with typos
+#define MIN_FUZZY_SEARCH 3
 
 Game::Game():
-  d(new Private)
+  _table(NULL),
+  _row(0)
 {}
 
-Game::Game(const Game& other):
-  d(new Private(*other.d))
-{
-}
+Game::Game(const GameTable* table, unsigned int row):
+  _table(table),
+  _row(row)
+{}
 
-Game& Game::operator=(const Game& other)
+bool Game::isValid() const
 {
-  if(&other == this)
-    return *this;
-
-  d = other.d;
-
-  return *this;
+  return _table != NULL && _row < _table->size();
 }
 
-Game::~Game()
+const GameTable* Game::getTable() const
 {
-  delete d;
+  return _table;
 }
 
-void Game::setPosition(unsigned int pos)
+unsigned int Game::getRow() const
 {
-  d->_position = pos;
+  return _row;
 }
 
 unsigned int Game::getPosition() const
 {
-  return d->_position;
-}
-
-void Game::setName(const std::string& name)
-{
-  d->_name = name;
-  if(d->_shortName.empty())
-    d->_shortName = name;
-  if(d->_sortKey.empty())
-    d->_sortKey = name;
-}
-
-const std::string& Game::getName() const
-{
-  return d->_name;
-}
-
-void Game::setShortName(const std::string& shortName)
-{
-  if(shortName.empty() && !d->_shortName.empty())
-    return;
-  d->_shortName = shortName.substr(0, MAX_SHORTNAME_LENGTH);
-}
-
-const std::string& Game::getShortName() const
-{
-  return d->_shortName;
+  return _table->position(_row);
 }
 
-void Game::setSortKey(const std::string& sortKey)
+string_view Game::getName() const
 {
-  if(sortKey.empty() && !d->_sortKey.empty())
-    return;
-  d->_sortKey = sortKey;
+  return _table->name(_row);
 }
 
-const std::string& Game::getSortKey() const
+string_view Game::getShortName() const
 {
-  return d->_sortKey;
+  return _table->shortName(_row);
 }
 
-void Game::addGameType(const std::string& type)
+string_view Game::getSortKey() const
 {
-  d->_gameTypes.push_back(type);
+  return _table->sortKey(_row);
 }
 
-const std::list<std::string>& Game::getGameTypes() const
+FacetIds Game::getGameTypeIds() const
 {
-  return d->_gameTypes;
+  return _table->types(_row);
 }
 
-void Game::setDevice(const std::string& device)
+unsigned int Game::getDeviceId() const
 {
-  d->_device = device;
+  return _table->device(_row);
 }
 
 const std::string& Game::getDevice() const
 {
-  return d->_device;
-}
-
-void Game::setNumPlayers(unsigned int numPlayers)
-{
-  d->_maxPlayers = numPlayers;
+  return FacetDictionary::devices().value(_table->device(_row));
 }
 
 unsigned int Game::getMaxPlayers() const
 {
-  return d->_maxPlayers;
+  return _table->maxPlayers(_row);
 }
 
 std::string Game::getMaxPlayersString() const
 {
-  switch(d->_maxPlayers)
+  switch(getMaxPlayers())
   {
   case 2:
       return "1P/2P";
@@ -197,51 +110,27 @@ std::string Game::getMaxPlayersString() const
   return "1P";
 }
 
-void Game::addGameFamily(const std::string& family)
-{
-  d->_gameFamily.push_back(family);
-}
-
-const std::list<std::string>& Game::getGameFamilies() const
-{
-  return d->_gameFamily;
-}
-
-void Game::setCommandLine(const string& commandLine)
-{
-  d->_commandLine = commandLine;
-}
-
-const string& Game::getCommandLine() const
+FacetIds Game::getGameFamilyIds() const
 {
-  return d->_commandLine;
+  return _table->families(_row);
 }
 
-void Game::setPicturePath(const string& picturePath)
+string_view Game::getCommandLine() const
 {
-  d->_picturePath = picturePath;
+  return _table->commandLine(_row);
 }
 
-const string& Game::getPicturePath() const
+string_view Game::getPicturePath() const
 {
-  return d->_picturePath;
+  return _table->picturePath(_row);
 }
 
 bool Game::operator <(const Game& other) const
 {
-  if(d->_sortKey != other.d->_sortKey)
-    return (d->_sortKey < other.d->_sortKey);
-
-  if(d->_name != other.d->_name)
-    return (d->_name < other.d->_name);
-
-  if(d->_shortName != other.d->_shortName)
-    return (d->_shortName < other.d->_shortName);
-
-  if(d->_device != other.d->_device)
-    return (d->_device < other.d->_device);
-
-  return true;
+  string key, otherKey;
+  Collation::key(*this, key);
+  Collation::key(other, otherKey);
+  return key < otherKey;
 }
 
 bool Game::matches(const string& type,
@@ -249,36 +138,24 @@ bool Game::matches(const string& type,
                    unsigned int numPlayers,
                    const string& family) const
 {
-//  cout << "matches " << d->_name.c_str() << endl;
+//  cout << "matches " << getName() << endl;
   if(!type.empty())
   {
-    bool hasType(false);
-    for(list<string>::iterator iter = d->_gameTypes.begin();
-        iter != d->_gameTypes.end() && !hasType;
-        ++iter)
-    {
-      hasType = (*iter == type);
-    }
-    if(!hasType)
+    int typeId = FacetDictionary::types().find(type);
+    if(typeId < 0 || !getGameTypeIds().contains(typeId))
       return false;
   }
 
-  if(!device.empty() && d->_device != device)
+  if(!device.empty() && getDevice() != device)
     return false;
 
-  if(d->_maxPlayers < numPlayers)
+  if(getMaxPlayers() < numPlayers)
     return false;
 
   if(!family.empty())
   {
-    bool hasFamily(false);
-    for(list<string>::iterator iter = d->_gameFamily.begin();
-        iter != d->_gameFamily.end() && !hasFamily;
-        ++iter)
-    {
-      hasFamily = (*iter == family);
-    }
-    if(!hasFamily)
+    int familyId = FacetDictionary::families().find(family);
+    if(familyId < 0 || !getGameFamilyIds().contains(familyId))
       return false;
   }
 //  cout << "YES" << endl;
@@ -294,32 +171,211 @@ class Content::Private
     ~Private();
 
     void reset();
-    void resetSelectedGames();
-    void regenerateSelection();
-
-    list<Game*> _allGames;
-    vector<Game*> _selectedGames;
-
-    vector<string> _types;
+    // The selection is computed again from the filters on all facets, or
+    // only from the filter on the changed facet
+    void regenerateSelection(FacetIndex::Facet changed = FacetIndex::NUM_FACETS);
+    // Selected rows listed again in the current order, and kept in the cube
+    void projectSelection();
+    // From the cube, false if the current filters are not there
+    bool findCachedSelection();
+    bool cubeKey(uint64_t& key) const;
+    const GameSet& selectedSet();
+    // sections: index in rows of the first game of each leading character
+    void project(const GameSet& games, vector<unsigned int>& rows, vector<unsigned int>& sections) const;
+    void sortOrders();
+    void applySortOrder();
+    void prepareFacet(FacetIndex::Facet facet);
+    // games &= the games of the current collection or query
+    void restrict(GameSet& games) const;
+    void buildCollections();
+    void prepareCollections();
+    int facetValue(FacetIndex::Facet facet) const;
+    vector<unsigned int>& facetCounts(FacetIndex::Facet facet);
+    void restartSearch();
+    void applySearch();
+    unsigned int playerCount(unsigned int minPlayers) const;
+    // Games of the current value of facet under the other filters, the
+    // search aside
+    unsigned int currentCount(FacetIndex::Facet facet);
+    // Value after or before current, -1 for "all". Values without games
+    // under the other filters are skipped.
+    static int nextValue(int current, const vector<unsigned int>& counts);
+    static int previousValue(int current, const vector<unsigned int>& counts);
+    // Rows to be filled again, shared with no Selection
+    static vector<unsigned int>& writable(shared_ptr<vector<unsigned int> >& rows);
+#ifdef PIXBOX_CHECK_INDEX
+    void checkSelection();
+#endif
+
+    GameTable _games;
+    FacetIndex _index;
+    // _selection is rebuilt from _selectedGames when they come from the cube
+    GameSet _selection;
+    bool _selectionValid;
+    shared_ptr<vector<unsigned int> > _selectedGames;
+    shared_ptr<vector<unsigned int> > _selectedSections;
+    FacetCube _cube;
+
+    // Facet values found in the catalog, as FacetDictionary ids
+    vector<unsigned int> _types;
+    vector<bool> _typeUsed;
     int _currentType;
     string _currentTypeString;
-    vector<string> _devices;
+    vector<unsigned int> _devices;
+    vector<bool> _deviceUsed;
     int _currentDevice;
     string _currentDeviceString;
     unsigned int _currentMinPlayers;
     string _currentMinPlayersString;
-    vector<string> _families;
+    vector<unsigned int> _families;
+    vector<bool> _familyUsed;
     int _currentFamily;
     string _currentFamilyString;
 
-    static bool comp(Game* first, Game* second);
+    // For each facet, the games selected by the filters on the other
+    // facets and the games of each value among them. Only valid until a
+    // filter on another facet changes, see prepareFacet().
+    GameSet _others[FacetIndex::NUM_FACETS];
+    bool _othersValid[FacetIndex::NUM_FACETS];
+    vector<unsigned int> _typeCounts;
+    vector<unsigned int> _deviceCounts;
+    vector<unsigned int> _playerCounts;
+    vector<unsigned int> _familyCounts;
+
+    // Saved collections, evaluated in buildCollections(). _query, when
+    // set, replaces the current collection.
+    vector<string> _collectionNames;
+    vector<string> _collectionQueries;
+    vector<GameSet> _collections;
+    vector<unsigned int> _collectionCounts;
+    int _currentCollection;
+    string _currentCollectionString;
+    FilterQuery _query;
+    GameSet _queryGames;
+
+    // Rows in each order, and position of each row in it. Rows are
+    // positions in catalog order: both are left empty for it.
+    Content::SortOrder _sortOrder;
+    vector<unsigned int> _orderRows[NUM_SORT_ORDERS];
+    vector<unsigned int> _orderPositions[NUM_SORT_ORDERS];
+    // Leading character of the key of each row in each order, the number of
+    // players for PLAYERS_ORDER
+    vector<unsigned char> _orderSections[NUM_SORT_ORDERS];
+
+    // Type-ahead search: _searchRanges holds the range of _names matching
+    // each prefix of the search text, the empty one first. When no name
+    // starts with the text, _fuzzy ranks the names close to it.
+    NameIndex _names;
+    FuzzyMatcher _fuzzy;
+    bool _searching;
+    string _searchText;
+    string _searchKey;
+    vector<unsigned int> _searchRanges;
+    bool _searchRanked;
+    GameSet _searchMatches;
+    shared_ptr<vector<unsigned int> > _searchResult;
+    shared_ptr<vector<unsigned int> > _searchSections;
+
+    vector<string> _prepareCommands;
+
+    // Hash of the CSV row of each game and of the macros it was expanded
+    // with, and the games by hash, so that a reload only parses the rows
+    // that changed
+    vector<uint64_t> _rowKeys;
+    unordered_map<uint64_t, unsigned int> _parsedRows;
+
+    // Game rows of the catalog file, with the macros in effect at each row
+    struct Row
+    {
+      string_view line;
+      unsigned int macros;
+      uint64_t key;
+    };
 
-    static list<string> split(const string&, const char sep);
-    static string macroSubstitution(const list< pair<string, string> >& macros, const string& str);
-    static string unixify(const string& command);
+    // Rows parsed by one loading thread
+    struct Chunk
+    {
+      const Row* begin;
+      const Row* end;
+      const vector<MacroExpander>* macros;
+      const GameTable* previousGames;
+      const unordered_map<uint64_t, unsigned int>* parsedRows;
+      GameTable games;
+      vector<uint64_t> keys;
+      unsigned int reused;
+      vector<unsigned int> types;
+      vector<bool> typeUsed;
+      vector<unsigned int> devices;
+      vector<bool> deviceUsed;
+      vector<unsigned int> families;
+      vector<bool> familyUsed;
+    };
+
+    // Shards loaded by a pool of threads
+    struct ShardLoading
+    {
+      const vector<string>* paths;
+      const Private* previous;
+      unsigned int numThreads;
+      mutex lock;
+      unsigned int next;
+      vector<Private*> shards;
+    };
+
+    // First game of a shard not merged yet
+    struct ShardHead
+    {
+      string key;
+      unsigned int shard;
+      unsigned int row;
+    };
+
+    // Parsing uses numThreads cores, all of them with 0. PREPARE lines are
+    // run as they are read, unless runCommands is false.
+    void loadFile(CatalogReader& reader, const Private* previous, unsigned int numThreads = 0, bool runCommands = true);
+    void mergeChunk(Chunk& chunk);
+    // Sorts the games, then builds the indexes
+    void finishLoading();
+    void sortGames();
+    void buildIndexes();
+    // Each shard of the directory is loaded from its own cache, or parsed
+    // and sorted on its own, then all are merged in catalog order
+    void loadShards(const string& directory, const Private* previous);
+    void mergeShards(const vector<Private*>& shards);
+    // Replays the journal over the sorted games: the games it adds or
+    // changes are inserted in place, without sorting all games again
+    void applyJournal(CatalogJournal& journal, const string& dataFile);
+    // PREPARE lines not run for the previous catalog
+    void runPrepareCommands(const Private* previous) const;
+    void indexRows();
+    void keepFilters(const Private& other);
+    bool loadCache(const CatalogCache& cache);
+    bool saveCache(const CatalogCache& cache) const;
+
+    static uint64_t hash(string_view str, uint64_t seed);
+    static void addFacet(vector<unsigned int>& facet, vector<bool>& used, unsigned int id);
+    static void addFacets(const Game& game,
+                          vector<unsigned int>& types, vector<bool>& typeUsed,
+                          vector<unsigned int>& devices, vector<bool>& deviceUsed,
+                          vector<unsigned int>& families, vector<bool>& familyUsed);
+
+    static void parseChunk(Chunk* chunk);
+    static void loadQueuedShards(ShardLoading* loading);
+    static Private* loadShard(const string& path, const Private* previous, unsigned int numThreads);
+    static bool laterHead(const ShardHead& first, const ShardHead& second);
+    static bool isShardDirectory(const string& path);
+    // The catalog file, or the shards of the directory
+    static void listCatalogs(const string& dataFile, vector<string>& catalogs);
+    // Game of an edit of the journal. Fields the edit does not set come from
+    // the row of base.
+    static void addEdit(const CatalogJournal::Edit& edit, const GameTable* base, unsigned int row, const MacroExpander& macros, GameTable& games);
+
+    static void unixify(string_view command, string& result);
+    static unsigned int parseNumPlayers(string_view numPlayers);
 };
 
-Content::Private::Private()
+Content::Private::Private():
+  _cube(FACET_CUBE_CAPACITY)
 {
   reset();
 }
@@ -331,21 +387,23 @@ Content::Private::~Private()
 
 void Content::Private::reset()
 {
-  for(list<Game*>::iterator iter = _allGames.begin();
-      iter != _allGames.end();
-      ++iter)
-  {
-    delete *iter;
-  }
-
-    _allGames.clear();
-  _selectedGames.clear();
+  _games.clear();
+  _rowKeys.clear();
+  _parsedRows.clear();
+  _selectedGames.reset();
+  _selectedSections.reset();
+  _index.clear();
+  _selection.resize(0);
+  _selectionValid = true;
+  _cube = FacetCube(_cube.capacity());
 
   _types.clear();
+  _typeUsed.clear();
   _currentType = -1;
   _currentTypeString.clear();
 
   _devices.clear();
+  _deviceUsed.clear();
   _currentDevice = -1;
   _currentDeviceString.clear();
 
@@ -353,357 +411,1460 @@ void Content::Private::reset()
   _currentMinPlayersString = "1P/2P/3P";
 
   _families.clear();
+  _familyUsed.clear();
   _currentFamily = -1;
   _currentFamilyString.clear();
+
+  for(unsigned int ii = 0; ii < FacetIndex::NUM_FACETS; ++ii)
+    _othersValid[ii] = false;
+  _typeCounts.clear();
+  _deviceCounts.clear();
+  _playerCounts.clear();
+  _familyCounts.clear();
+
+  _collectionNames.clear();
+  _collectionQueries.clear();
+  _collections.clear();
+  _collectionCounts.clear();
+  _currentCollection = -1;
+  _currentCollectionString.clear();
+  _query.clear();
+  _queryGames.resize(0);
+
+  _sortOrder = CATALOG_ORDER;
+  for(unsigned int ii = 0; ii < NUM_SORT_ORDERS; ++ii)
+  {
+    _orderRows[ii].clear();
+    _orderPositions[ii].clear();
+    _orderSections[ii].clear();
+  }
+
+  _names.clear();
+  _fuzzy.clear();
+  _searching = false;
+  _searchText.clear();
+  _searchKey.clear();
+  _searchRanges.clear();
+  _searchRanked = false;
+  _searchResult.reset();
+  _searchSections.reset();
+
+  _prepareCommands.clear();
 }
 
-void Content::Private::regenerateSelection()
+void Content::Private::regenerateSelection(FacetIndex::Facet changed)
 {
-  _selectedGames.clear();
+  for(unsigned int ii = 0; ii < FacetIndex::NUM_FACETS; ++ii)
+  {
+    if(ii != (unsigned int) changed)
+      _othersValid[ii] = false;
+  }
 
-  for(list<Game*>::iterator iter = _allGames.begin();
-      iter != _allGames.end();
-      ++iter)
+  if(!findCachedSelection())
   {
-    if((*iter)->matches(_currentTypeString,
-                        _currentDeviceString,
-                        _currentMinPlayers,
-                        _currentFamilyString))
+    if(changed < FacetIndex::NUM_FACETS)
+    {
+      // The other filters did not change: one intersection
+      prepareFacet(changed);
+      _selection = _others[changed];
+      _index.intersect(changed, facetValue(changed), _selection);
+    }
+    else
     {
-      _selectedGames.push_back(*iter);
+      _index.select(_currentType,
+                    _currentDevice,
+                    _currentMinPlayers,
+                    _currentFamily,
+                    _selection);
+      restrict(_selection);
     }
+    _selectionValid = true;
+
+    projectSelection();
   }
+
+#ifdef PIXBOX_CHECK_INDEX
+  checkSelection();
+#endif
 }
 
-void Content::Private::resetSelectedGames()
+void Content::Private::projectSelection()
 {
-  for(vector<Game*>::iterator iter = _selectedGames.begin();
-      iter != _selectedGames.end();
-      ++iter)
-  {
-    delete *iter;
-  }
+  const GameSet& selection = selectedSet();
+  vector<unsigned int>& selectedGames = writable(_selectedGames);
+  selectedGames.reserve(selection.count());
+  project(selection, selectedGames, writable(_selectedSections));
+
+  uint64_t key;
+  if(cubeKey(key))
+    _cube.insert(key, _selectedGames, _selectedSections);
+
+  if(_searching)
+    applySearch();
 }
 
-bool Content::Private::comp(Game* first, Game* second)
+bool Content::Private::findCachedSelection()
 {
-  return (*first < *second);
+  uint64_t key;
+  if(!cubeKey(key))
+    return false;
+
+  if(!_cube.find(key, _selectedGames, _selectedSections))
+    return false;
+
+  _selectionValid = false;
+  if(_searching)
+    applySearch();
+  return true;
 }
 
-list<string> Content::Private::split(const string & str, const char sep)
+bool Content::Private::cubeKey(uint64_t& key) const
 {
-  string temp(str);
-  list<string> res;
+  // 16 bits per facet value but players, 8 bits for the collection, 255
+  // being the query, and 2 bits for the order. Larger values are not kept.
+  unsigned int restriction = !_query.empty() ? 255 : _currentCollection + 1;
+  if(_currentType + 1 > 0xFFFF ||
+     _currentDevice + 1 > 0xFFFF ||
+     _currentFamily + 1 > 0xFFFF ||
+     _currentMinPlayers > 0x3F ||
+     restriction > 0xFF ||
+     _sortOrder > 3)
+    return false;
 
-  if(str.empty())
-    return res;
+  key = (uint64_t) (_currentType + 1) |
+        (uint64_t) (_currentDevice + 1) << 16 |
+        (uint64_t) (_currentFamily + 1) << 32 |
+        (uint64_t) _currentMinPlayers << 48 |
+        (uint64_t) restriction << 54 |
+        (uint64_t) _sortOrder << 62;
+  return true;
+}
 
-  size_t pos = temp.find(sep, 0);
-  while(pos != string::npos)
+const GameSet& Content::Private::selectedSet()
+{
+  if(!_selectionValid)
   {
-    res.push_back(temp.substr(0, pos));
-    temp = temp.substr(pos + 1, temp.length());
-    pos = temp.find(sep, 0);
+    _selection.resize(_games.size());
+    for(unsigned int ii = 0; ii < _selectedGames->size(); ++ii)
+      _selection.set((*_selectedGames)[ii]);
+    _selectionValid = true;
   }
-  res.push_back(temp);
-
-  return res;
+  return _selection;
 }
 
-string Content::Private::macroSubstitution(const list< pair<string, string> >& macros, const string& str)
+void Content::Private::project(const GameSet& games, vector<unsigned int>& rows, vector<unsigned int>& sections) const
 {
-  string result(str);
-  for(list< pair <string, string> >::const_iterator iter = macros.begin();
-      iter != macros.end();
-      ++iter)
+  rows.clear();
+  sections.clear();
+  if(_sortOrder == CATALOG_ORDER)
   {
-    string macro = iter->first;
-    int macroSize = macro.length();
-    string subst = iter->second;
-    int position = result.find(macro);
-    while(position != string::npos)
+    games.indices(rows);
+  }
+  else
+  {
+    const vector<unsigned int>& order = _orderRows[_sortOrder];
+    for(unsigned int ii = 0; ii < order.size(); ++ii)
     {
-      result = result.replace(position, macroSize, subst);
-      position = result.find(macro);
+      if(games.test(order[ii]))
+        rows.push_back(order[ii]);
     }
-
   }
 
-  return result;
+  // Rows are sorted by their key: each character starts a run
+  const vector<unsigned char>& leading = _orderSections[_sortOrder];
+  if(leading.size() != _games.size())
+    return;
+  for(unsigned int ii = 0; ii < rows.size(); ++ii)
+  {
+    if(ii == 0 || leading[rows[ii]] != leading[rows[ii - 1]])
+      sections.push_back(ii);
+  }
 }
 
-string Content::Private::unixify(const string& command)
+void Content::Private::sortOrders()
 {
-  string res;
-  for(unsigned int ii = 0; ii < command.length(); ++ii)
+  // Catalog order starts with the sort key without its article
+  string keyBuffer;
+  vector<unsigned char>& catalogSections = _orderSections[CATALOG_ORDER];
+  catalogSections.resize(_games.size());
+  for(unsigned int ii = 0; ii < _games.size(); ++ii)
   {
-    switch(command[ii])
+    keyBuffer.clear();
+    Collation::normalize(_games.sortKey(ii), keyBuffer);
+    string_view stripped = Collation::stripArticle(keyBuffer);
+    catalogSections[ii] = stripped.empty() ? 0 : stripped[0];
+  }
+
+  // Equal games keep catalog order
+  vector<size_t> keyOffsets;
+  vector<string_view> keys;
+  for(unsigned int order = NAME_ORDER; order < NUM_SORT_ORDERS; ++order)
+  {
+    keyBuffer.clear();
+    keyOffsets.assign(1, 0);
+    for(unsigned int ii = 0; ii < _games.size(); ++ii)
     {
-      case ' ':
-      case '(':
-      case ')':
-      case '&':
-	case '[':
-	case ']':
-	case '!':
-      case '\'':
-        res += '\\';
-        res += command[ii];
-        break;
+      switch(order)
+      {
+      case NAME_ORDER:
+          // The name as displayed, articles included
+          Collation::normalize(_games.name(ii), keyBuffer);
+          break;
 
-      case '\r':
-        break;
+      case DEVICE_ORDER:
+          Collation::normalize(FacetDictionary::devices().value(_games.device(ii)), keyBuffer);
+          break;
 
       default:
-        res += command[ii];
-        break;
+          // Big endian, so that bytes compare as numbers
+          for(int shift = 24; shift >= 0; shift -= 8)
+            keyBuffer += (char) ((_games.maxPlayers(ii) >> shift) & 0xFF);
+          break;
+      }
+      keyOffsets.push_back(keyBuffer.size());
+    } // end for(unsigned int ii = 0; ii < _games.size(); ++ii)
+
+    keys.clear();
+    keys.reserve(_games.size());
+    for(unsigned int ii = 0; ii < _games.size(); ++ii)
+      keys.push_back(string_view(keyBuffer).substr(keyOffsets[ii], keyOffsets[ii + 1] - keyOffsets[ii]));
+
+    vector<unsigned int>& rows = _orderRows[order];
+    rows.resize(_games.size());
+    for(unsigned int ii = 0; ii < rows.size(); ++ii)
+      rows[ii] = ii;
+    Collation::sort(keys, rows);
+
+    vector<unsigned int>& positions = _orderPositions[order];
+    positions.resize(rows.size());
+    for(unsigned int ii = 0; ii < rows.size(); ++ii)
+      positions[rows[ii]] = ii;
+
+    vector<unsigned char>& sections = _orderSections[order];
+    sections.resize(_games.size());
+    for(unsigned int ii = 0; ii < _games.size(); ++ii)
+    {
+      if(order == PLAYERS_ORDER)
+        sections[ii] = _games.maxPlayers(ii) < 0xFF ? _games.maxPlayers(ii) : 0xFF;
+      else
+        sections[ii] = keys[ii].empty() ? 0 : keys[ii][0];
     }
-  } // end for(unsigned int ii = 0; ii < command.length(); ++ii)
-
-  return res;
+  } // end for(unsigned int order = NAME_ORDER; order < NUM_SORT_ORDERS; ++order)
 }
 
-Content::Content():
-  d(new Private)
+void Content::Private::applySortOrder()
 {
-
+  _games.setPositions(_sortOrder == CATALOG_ORDER ? NULL : _orderPositions[_sortOrder].data());
 }
 
-Content::~Content()
+void Content::Private::prepareFacet(FacetIndex::Facet facet)
 {
-  delete d;
+  if(_othersValid[facet])
+    return;
+
+  _index.select(facet == FacetIndex::TYPE ? -1 : _currentType,
+                facet == FacetIndex::DEVICE ? -1 : _currentDevice,
+                facet == FacetIndex::PLAYERS ? 0 : _currentMinPlayers,
+                facet == FacetIndex::FAMILY ? -1 : _currentFamily,
+                _others[facet]);
+  restrict(_others[facet]);
+  _index.count(facet, _others[facet], facetCounts(facet));
+  _othersValid[facet] = true;
 }
 
-void Content::startAddingGames()
+void Content::Private::restrict(GameSet& games) const
 {
-  d->reset();
+  if(!_query.empty())
+    games &= _queryGames;
+  else if(_currentCollection >= 0)
+    games &= _collections[_currentCollection];
 }
 
-void Content::addGame(const Game& game)
+void Content::Private::buildCollections()
 {
-  d->_allGames.push_back(new Game(game));
-
-  const std::list<string>& types = game.getGameTypes();
-
-  // Add type
-  for(list<string>::const_iterator gameTypeIter = types.begin();
-      gameTypeIter != types.end();
-      ++gameTypeIter)
-  {
-    bool found(false);
-
-    for(vector<string>::const_iterator currentTypeIter = d->_types.begin();
-        currentTypeIter != d->_types.end() && !found;
-        ++currentTypeIter)
-    {
-      if(*currentTypeIter == *gameTypeIter)
-      {
-        found = true;
-      }
-    }
-    if(!found)
-    {
-      d->_types.push_back(*gameTypeIter);
-    }
-  } // end for(std::list<std::string>::const_iterator* gameTypeIter = types.begin();
-
-  // Add device
+  // Once per load: cycling through collections is then a matter of
+  // bitset intersections
+  _collections.assign(_collectionNames.size(), GameSet(_games.size()));
+  FilterQuery query;
+  string message;
+  for(unsigned int ii = 0; ii < _collectionNames.size(); ++ii)
   {
-    bool found(false);
-
-    for(vector<string>::const_iterator currentDeviceIter = d->_devices.begin();
-        currentDeviceIter != d->_devices.end() && !found;
-        ++currentDeviceIter)
-    {
-      if(*currentDeviceIter == game.getDevice())
-      {
-        found = true;
-      }
-    }
-    if(!found)
-    {
-      d->_devices.push_back(game.getDevice());
-    }
-  } // end for(vector<string>::const_iterator currentDeviceIter = d->_devices.begin();
-
-  const std::list<string>& families = game.getGameFamilies();
+    if(query.parse(_collectionQueries[ii], message))
+      query.evaluate(_index, _names, _collections[ii]);
+    else if(!IsQuiet)
+      cerr << "Collection " << _collectionNames[ii] << ": " << message << endl;
+  }
+}
 
-  // Add family
-  for(list<string>::const_iterator gameFamilyIter = families.begin();
-      gameFamilyIter != families.end();
-      ++gameFamilyIter)
-  {
-    if(!gameFamilyIter->empty())
+void Content::Private::prepareCollections()
 {
-          bool found(false);
-    for(vector<string>::const_iterator currentFamilyIter = d->_families.begin();
-        currentFamilyIter != d->_families.end() && !found;
-        ++currentFamilyIter)
-    {
-      if(*gameFamilyIter == *currentFamilyIter)
-      {
-        found = true;
-      }
-    }
-    if(!found)
-    {
-      d->_families.push_back(*gameFamilyIter);
-    }
-    }
-  } // end for(list<string>::const_iterator gameFamilyIter = families.begin();
+  // Games of each collection under the facet filters
+  GameSet others;
+  _index.select(_currentType, _currentDevice, _currentMinPlayers, _currentFamily, others);
+  _collectionCounts.resize(_collections.size());
+  for(unsigned int ii = 0; ii < _collections.size(); ++ii)
+    _collectionCounts[ii] = others.countCommon(_collections[ii]);
 }
 
-void Content::stopAddingGames()
+int Content::Private::facetValue(FacetIndex::Facet facet) const
 {
-  d->_allGames.sort(Content::Private::comp);
+  switch(facet)
+  {
+    case FacetIndex::TYPE: return _currentType;
+    case FacetIndex::DEVICE: return _currentDevice;
+    case FacetIndex::PLAYERS: return _currentMinPlayers;
+    default: return _currentFamily;
+  }
+}
 
-  unsigned int counter(0);
-  for(list<Game*>::iterator iter = d->_allGames.begin();
-      iter != d->_allGames.end();
-      ++iter)
+vector<unsigned int>& Content::Private::facetCounts(FacetIndex::Facet facet)
+{
+  switch(facet)
   {
-    (*iter)->setPosition(counter++);
+    case FacetIndex::TYPE: return _typeCounts;
+    case FacetIndex::DEVICE: return _deviceCounts;
+    case FacetIndex::PLAYERS: return _playerCounts;
+    default: return _familyCounts;
   }
+}
 
-  std::sort(d->_devices.begin(), d->_devices.end());
-  std::sort(d->_types.begin(), d->_types.end());
-  std::sort(d->_families.begin(), d->_families.end());
-  d->regenerateSelection();
+vector<unsigned int>& Content::Private::writable(shared_ptr<vector<unsigned int> >& rows)
+{
+  // Selections handed out keep the rows they were given
+  if(!rows || rows.use_count() > 1)
+    rows = make_shared<vector<unsigned int> >();
+  return *rows;
 }
 
-const string& Content::nextGameType()
+void Content::Private::restartSearch()
 {
-  ++d->_currentType;
+  _searchKey.clear();
+  _searchRanges.assign(1, 0);
+  _searchRanges.push_back(_names.size());
 
-  if(d->_currentType >= d->_types.size())
-  {
-    d->_currentType = -1;
-    d->_currentTypeString.clear();
-  }
-  else
+  for(unsigned int ii = 0; ii < _searchText.size(); ++ii)
   {
-    d->_currentTypeString = d->_types[d->_currentType];
+    Collation::normalize(string_view(_searchText).substr(ii, 1), _searchKey);
+    unsigned int first = _searchRanges[_searchRanges.size() - 2];
+    unsigned int last = _searchRanges.back();
+    _names.narrow(_searchKey, first, last);
+    _searchRanges.push_back(first);
+    _searchRanges.push_back(last);
   }
-
-  d->regenerateSelection();
-
-  return d->_currentTypeString;
 }
 
-const string& Content::nextDevice()
+void Content::Private::applySearch()
 {
-  ++d->_currentDevice;
-
-  if(d->_currentDevice >= d->_devices.size())
+  _searchRanked = false;
+  if(_searchText.empty())
   {
-    d->_currentDevice = -1;
-    d->_currentDeviceString.clear();
+    _searchResult = _selectedGames;
+    _searchSections = _selectedSections;
+    return;
   }
-  else
+
+  unsigned int first = _searchRanges[_searchRanges.size() - 2];
+  unsigned int last = _searchRanges.back();
+  if(first == last && _searchKey.size() >= MIN_FUZZY_SEARCH)
   {
-    d->_currentDeviceString = d->_devices[d->_currentDevice];
+    // About one typo every four characters
+    unsigned int maxDistance = max<unsigned int>(1, _searchKey.size() / 4);
+    _fuzzy.search(_searchText, maxDistance, selectedSet(), writable(_searchResult));
+    _searchSections.reset();
+    _searchRanked = true;
+    return;
   }
 
-  d->regenerateSelection();
+  _searchMatches.resize(_games.size());
+  for(unsigned int entry = first; entry < last; ++entry)
+    _searchMatches.set(_names.row(entry));
+  _searchMatches &= selectedSet();
 
-  return d->_currentDeviceString;
+  project(_searchMatches, writable(_searchResult), writable(_searchSections));
 }
 
-const string& Content::nextMultiplayer()
+unsigned int Content::Private::playerCount(unsigned int minPlayers) const
 {
-    switch(d->_currentMinPlayers)
-    {
-    case 2:
-        d->_currentMinPlayers = 3;
-        d->_currentMinPlayersString = "3P";
-        break;
-
-    case 3:
-        d->_currentMinPlayers = 1;
-        d->_currentMinPlayersString = "1P/2P/3P";
-        break;
+  unsigned int threshold = _index.playerThreshold(minPlayers);
+  return threshold < _playerCounts.size() ? _playerCounts[threshold] : 0;
+}
 
-    default:
-        d->_currentMinPlayers = 2;
-        d->_currentMinPlayersString = "2P/3P";
-        break;
-    }
+unsigned int Content::Private::currentCount(FacetIndex::Facet facet)
+{
+  prepareFacet(facet);
+  if(facet == FacetIndex::PLAYERS)
+    return playerCount(_currentMinPlayers);
+  int value = facetValue(facet);
+  if(value < 0)
+    return _others[facet].count();
+  return facetCounts(facet)[value];
+}
 
-  d->regenerateSelection();
+int Content::Private::nextValue(int current, const vector<unsigned int>& counts)
+{
+  unsigned int value = current + 1;
+  while(value < counts.size() && counts[value] == 0)
+    ++value;
+  return value < counts.size() ? (int) value : -1;
+}
 
-  return d->_currentMinPlayersString;
+int Content::Private::previousValue(int current, const vector<unsigned int>& counts)
+{
+  int value = current < 0 ? (int) counts.size() - 1 : current - 1;
+  while(value >= 0 && counts[value] == 0)
+    --value;
+  return value;
 }
 
-const string& Content::nextGameFamily()
+#ifdef PIXBOX_CHECK_INDEX
+void Content::Private::checkSelection()
 {
-  ++d->_currentFamily;
+  for(unsigned int ii = 0; ii < FacetIndex::NUM_FACETS; ++ii)
+    prepareFacet((FacetIndex::Facet) ii);
+
+  // Reference path: Game::matches() and FilterQuery::matches() on every game
+  FilterQuery restriction(_query);
+  string message;
+  if(restriction.empty() && _currentCollection >= 0)
+    restriction.parse(_collectionQueries[_currentCollection], message);
 
-  if(d->_currentFamily >= d->_families.size())
+  vector<unsigned int> expected;
+  for(unsigned int ii = 0; ii < _games.size(); ++ii)
   {
-    d->_currentFamily = -1;
-    d->_currentFamilyString.clear();
+    unsigned int row = _sortOrder == CATALOG_ORDER ? ii : _orderRows[_sortOrder][ii];
+    if(Game(&_games, row).matches(_currentTypeString,
+                                  _currentDeviceString,
+                                  _currentMinPlayers,
+                                  _currentFamilyString) &&
+       restriction.matches(Game(&_games, row)))
+    {
+      expected.push_back(row);
+    }
   }
-  else
+
+  if(expected != *_selectedGames)
   {
-    d->_currentFamilyString = d->_families[d->_currentFamily];
+    cerr << "Facet index mismatch: " << _selectedGames->size()
+         << " games selected, " << expected.size() << " expected" << endl;
   }
 
-  d->regenerateSelection();
-
-  return d->_currentFamilyString;
-}
-
-
-
-
-const string& Content::previousGameType()
-{
-  if(d->_currentType < 0)
+  for(unsigned int ii = 0; ii < _types.size(); ++ii)
   {
-    d->_currentType = d->_types.size() - 1;
+    unsigned int count(0);
+    for(unsigned int game = 0; game < _games.size(); ++game)
+    {
+      if(Game(&_games, game).matches(FacetDictionary::types().value(_types[ii]), _currentDeviceString, _currentMinPlayers, _currentFamilyString) &&
+         restriction.matches(Game(&_games, game)))
+        ++count;
+    }
+    if(count != _typeCounts[ii])
+      cerr << "Type count mismatch: " << _typeCounts[ii] << " games, " << count << " expected" << endl;
   }
-  else
+  for(unsigned int ii = 0; ii < _devices.size(); ++ii)
   {
-    --d->_currentType;
+    unsigned int count(0);
+    for(unsigned int game = 0; game < _games.size(); ++game)
+    {
+      if(Game(&_games, game).matches(_currentTypeString, FacetDictionary::devices().value(_devices[ii]), _currentMinPlayers, _currentFamilyString) &&
+         restriction.matches(Game(&_games, game)))
+        ++count;
+    }
+    if(count != _deviceCounts[ii])
+      cerr << "Device count mismatch: " << _deviceCounts[ii] << " games, " << count << " expected" << endl;
   }
-
-  if(d->_currentType < 0)
+  for(unsigned int players = 1; players <= 3; ++players)
   {
-    d->_currentType = -1;
-    d->_currentTypeString.clear();
+    unsigned int count(0);
+    for(unsigned int game = 0; game < _games.size(); ++game)
+    {
+      if(Game(&_games, game).matches(_currentTypeString, _currentDeviceString, players, _currentFamilyString) &&
+         restriction.matches(Game(&_games, game)))
+        ++count;
+    }
+    if(count != playerCount(players))
+      cerr << "Players count mismatch: " << playerCount(players) << " games, " << count << " expected" << endl;
   }
-  else
+  for(unsigned int ii = 0; ii < _families.size(); ++ii)
   {
-    d->_currentTypeString = d->_types[d->_currentType];
+    unsigned int count(0);
+    for(unsigned int game = 0; game < _games.size(); ++game)
+    {
+      if(Game(&_games, game).matches(_currentTypeString, _currentDeviceString, _currentMinPlayers, FacetDictionary::families().value(_families[ii])) &&
+         restriction.matches(Game(&_games, game)))
+        ++count;
+    }
+    if(count != _familyCounts[ii])
+      cerr << "Family count mismatch: " << _familyCounts[ii] << " games, " << count << " expected" << endl;
   }
+}
+#endif
 
-  d->regenerateSelection();
+uint64_t Content::Private::hash(string_view str, uint64_t seed)
+{
+  // FNV-1a
+  uint64_t res = seed;
+  for(unsigned int ii = 0; ii < str.size(); ++ii)
+  {
+    res ^= (unsigned char) str[ii];
+    res *= 1099511628211ULL;
+  }
+  return res;
+}
+
+void Content::Private::addFacet(vector<unsigned int>& facet, vector<bool>& used, unsigned int id)
+{
+  if(id >= used.size())
+    used.resize(id + 1, false);
+
+  if(!used[id])
+  {
+    used[id] = true;
+    facet.push_back(id);
+  }
+}
+
+void Content::Private::unixify(string_view command, string& res)
+{
+  res.clear();
+  for(unsigned int ii = 0; ii < command.length(); ++ii)
+  {
+    switch(command[ii])
+    {
+      case ' ':
+      case '(':
+      case ')':
+      case '&':
+	case '[':
+	case ']':
+	case '!':
+      case '\'':
+        res += '\\';
+        res += command[ii];
+        break;
+
+      case '\r':
+        break;
+
+      default:
+        res += command[ii];
+        break;
+    }
+  } // end for(unsigned int ii = 0; ii < command.length(); ++ii)
+}
+
+void Content::Private::addFacets(const Game& game,
+                                 vector<unsigned int>& types, vector<bool>& typeUsed,
+                                 vector<unsigned int>& devices, vector<bool>& deviceUsed,
+                                 vector<unsigned int>& families, vector<bool>& familyUsed)
+{
+  FacetIds gameTypes = game.getGameTypeIds();
+  for(const unsigned int* iter = gameTypes.begin();
+      iter != gameTypes.end();
+      ++iter)
+  {
+    addFacet(types, typeUsed, *iter);
+  }
+
+  addFacet(devices, deviceUsed, game.getDeviceId());
+
+  FacetIds gameFamilies = game.getGameFamilyIds();
+  for(const unsigned int* iter = gameFamilies.begin();
+      iter != gameFamilies.end();
+      ++iter)
+  {
+    addFacet(families, familyUsed, *iter);
+  }
+}
+
+void Content::Private::parseChunk(Chunk* chunk)
+{
+  vector<string_view> split;
+  vector<string_view> types;
+  vector<unsigned int> typeIds, familyIds;
+  string artwork, command, unixified;
+
+  chunk->games.reserve(chunk->end - chunk->begin);
+  chunk->keys.reserve(chunk->end - chunk->begin);
+  chunk->reused = 0;
+
+  for(const Row* row = chunk->begin; row != chunk->end; ++row)
+  {
+    chunk->keys.push_back(row->key);
+
+    if(chunk->parsedRows != NULL)
+    {
+      unordered_map<uint64_t, unsigned int>::const_iterator parsed = chunk->parsedRows->find(row->key);
+      if(parsed != chunk->parsedRows->end())
+      {
+        unsigned int game = chunk->games.addGame(*chunk->previousGames, parsed->second);
+        addFacets(Game(&chunk->games, game),
+                  chunk->types, chunk->typeUsed,
+                  chunk->devices, chunk->deviceUsed,
+                  chunk->families, chunk->familyUsed);
+        ++chunk->reused;
+        continue;
+      }
+    }
+
+    const MacroExpander& macros = (*chunk->macros)[row->macros];
+    CatalogReader::split(row->line, ';', split);
+
+    string_view title,
+        shortTitle,
+        sortKey,
+        device,
+        family,
+        numPlayers;
+    artwork.clear();
+    command.clear();
+    types.clear();
+    unsigned int field(0);
+    if(field < split.size()) {title = split[field++];}
+    if(field < split.size()) {shortTitle = split[field++];}
+    if(field < split.size()) {sortKey = split[field++];}
+    if(field < split.size()) {CatalogReader::split(split[field++], '%', types);}
+    if(field < split.size()) {device = split[field++];}
+    if(field < split.size()) {numPlayers = split[field++];}
+    if(field < split.size()) {family = split[field++];}
+    if(field < split.size()) {macros.expand(split[field++], artwork);}
+    if(field < split.size()) {unixify(split[field++], unixified); macros.expand(unixified, command);}
+
+    typeIds.clear();
+    for(vector<string_view>::const_iterator iter = types.begin(); iter != types.end(); ++iter)
+      typeIds.push_back(FacetDictionary::types().intern(*iter));
+    // An empty family never matches a family filter
+    familyIds.clear();
+    if(!family.empty())
+      familyIds.push_back(FacetDictionary::families().intern(family));
+
+    unsigned int game = chunk->games.addGame(title,
+                                             shortTitle,
+                                             sortKey,
+                                             typeIds,
+                                             FacetDictionary::devices().intern(device),
+                                             parseNumPlayers(numPlayers),
+                                             familyIds,
+                                             artwork,
+                                             command);
+    addFacets(Game(&chunk->games, game),
+              chunk->types, chunk->typeUsed,
+              chunk->devices, chunk->deviceUsed,
+              chunk->families, chunk->familyUsed);
+  } // end for(const Row* row = chunk->begin; row != chunk->end; ++row)
+}
+
+void Content::Private::mergeChunk(Chunk& chunk)
+{
+  _games.append(chunk.games);
+  _rowKeys.insert(_rowKeys.end(), chunk.keys.begin(), chunk.keys.end());
+  chunk.games.clear();
+
+  for(unsigned int ii = 0; ii < chunk.types.size(); ++ii)
+    addFacet(_types, _typeUsed, chunk.types[ii]);
+  for(unsigned int ii = 0; ii < chunk.devices.size(); ++ii)
+    addFacet(_devices, _deviceUsed, chunk.devices[ii]);
+  for(unsigned int ii = 0; ii < chunk.families.size(); ++ii)
+    addFacet(_families, _familyUsed, chunk.families[ii]);
+}
+
+void Content::Private::finishLoading()
+{
+  sortGames();
+  buildIndexes();
+}
+
+void Content::Private::sortGames()
+{
+  // Rows are reordered so that the row of a game is its position
+  string keyBuffer, key;
+  vector<size_t> keyOffsets(1, 0);
+  for(unsigned int ii = 0; ii < _games.size(); ++ii)
+  {
+    Collation::key(Game(&_games, ii), key);
+    keyBuffer.append(key);
+    keyOffsets.push_back(keyBuffer.size());
+  }
+  vector<string_view> keys;
+  keys.reserve(_games.size());
+  for(unsigned int ii = 0; ii < _games.size(); ++ii)
+    keys.push_back(string_view(keyBuffer).substr(keyOffsets[ii], keyOffsets[ii + 1] - keyOffsets[ii]));
+
+  vector<unsigned int> order(_games.size());
+  for(unsigned int ii = 0; ii < order.size(); ++ii)
+    order[ii] = ii;
+  Collation::sort(keys, order);
+  _games.reorder(order);
+  _games.shrink();
+
+  vector<uint64_t> rowKeys(order.size());
+  for(unsigned int ii = 0; ii < order.size(); ++ii)
+    rowKeys[ii] = _rowKeys[order[ii]];
+  _rowKeys.swap(rowKeys);
+}
+
+void Content::Private::buildIndexes()
+{
+  indexRows();
+
+  FacetDictionary::devices().sort(_devices);
+  FacetDictionary::types().sort(_types);
+  FacetDictionary::families().sort(_families);
+
+  _index.build(_games, _types, _devices, _families);
+  _names.build(_games);
+  _fuzzy.build(_games);
+  buildCollections();
+  sortOrders();
+  applySortOrder();
+  regenerateSelection();
+}
+
+void Content::Private::loadShards(const string& directory, const Private* previous)
+{
+  vector<string> paths;
+  CatalogReader::list(directory, ".csv", paths);
+
+  // One shard per core, the cores left over parse chunks of the shards
+  unsigned int numThreads = thread::hardware_concurrency();
+  if(numThreads == 0)
+    numThreads = 1;
+  unsigned int numWorkers = paths.size() < numThreads ? paths.size() : numThreads;
+
+  ShardLoading loading;
+  loading.paths = &paths;
+  loading.previous = previous;
+  loading.numThreads = numWorkers > 0 ? numThreads / numWorkers : 1;
+  loading.next = 0;
+  loading.shards.resize(paths.size(), NULL);
+
+  vector<thread> threads;
+  for(unsigned int ii = 1; ii < numWorkers; ++ii)
+    threads.push_back(thread(loadQueuedShards, &loading));
+  loadQueuedShards(&loading);
+  for(unsigned int ii = 0; ii < threads.size(); ++ii)
+    threads[ii].join();
+
+  mergeShards(loading.shards);
+  for(unsigned int ii = 0; ii < loading.shards.size(); ++ii)
+    delete loading.shards[ii];
+
+  // In shard order, once all are read
+  runPrepareCommands(previous);
+}
+
+void Content::Private::loadQueuedShards(ShardLoading* loading)
+{
+  while(true)
+  {
+    unsigned int shard;
+    {
+      lock_guard<mutex> lock(loading->lock);
+      if(loading->next >= loading->paths->size())
+        return;
+      shard = loading->next++;
+    }
+    loading->shards[shard] = loadShard((*loading->paths)[shard], loading->previous, loading->numThreads);
+  }
+}
+
+Content::Private* Content::Private::loadShard(const string& path, const Private* previous, unsigned int numThreads)
+{
+  Private* shard = new Private;
+
+  // Read, not mapped, when reloading: the file may be rewritten meanwhile
+  CatalogReader reader;
+  if(!reader.open(path, previous != NULL))
+    return shard;
+
+  // snes.csv is cached in snes.cache
+  CatalogCache cache(path.substr(0, path.size() - 4) + ".cache");
+  cache.identify(path, reader.data(), reader.size());
+  if(!shard->loadCache(cache))
+  {
+    shard->loadFile(reader, previous, numThreads, false);
+    shard->sortGames();
+    shard->saveCache(cache);
+  }
+  return shard;
+}
+
+bool Content::Private::laterHead(const ShardHead& first, const ShardHead& second)
+{
+  int order = first.key.compare(second.key);
+  if(order != 0)
+    return order > 0;
+  return first.shard > second.shard;
+}
+
+void Content::Private::mergeShards(const vector<Private*>& shards)
+{
+  unsigned int numGames(0);
+  for(unsigned int ii = 0; ii < shards.size(); ++ii)
+    numGames += shards[ii]->_games.size();
+  _games.reserve(numGames);
+  _rowKeys.reserve(numGames);
+
+  // Shards are sorted already: the first game left in each is kept in a
+  // heap. Equal keys are taken in shard order, as if the shards were one
+  // file sorted at once.
+  vector<ShardHead> heads;
+  for(unsigned int ii = 0; ii < shards.size(); ++ii)
+  {
+    if(shards[ii]->_games.size() == 0)
+      continue;
+    ShardHead head;
+    head.shard = ii;
+    head.row = 0;
+    Collation::key(Game(&shards[ii]->_games, 0), head.key);
+    heads.push_back(head);
+  }
+  make_heap(heads.begin(), heads.end(), laterHead);
+
+  while(!heads.empty())
+  {
+    pop_heap(heads.begin(), heads.end(), laterHead);
+    ShardHead& head = heads.back();
+    const Private* shard = shards[head.shard];
+    _games.addGame(shard->_games, head.row);
+    _rowKeys.push_back(shard->_rowKeys[head.row]);
+
+    if(++head.row < shard->_games.size())
+    {
+      Collation::key(Game(&shard->_games, head.row), head.key);
+      push_heap(heads.begin(), heads.end(), laterHead);
+    }
+    else
+    {
+      heads.pop_back();
+    }
+  } // end while(!heads.empty())
+  _games.shrink();
+
+  for(unsigned int ii = 0; ii < shards.size(); ++ii)
+  {
+    const Private* shard = shards[ii];
+    for(unsigned int jj = 0; jj < shard->_types.size(); ++jj)
+      addFacet(_types, _typeUsed, shard->_types[jj]);
+    for(unsigned int jj = 0; jj < shard->_devices.size(); ++jj)
+      addFacet(_devices, _deviceUsed, shard->_devices[jj]);
+    for(unsigned int jj = 0; jj < shard->_families.size(); ++jj)
+      addFacet(_families, _familyUsed, shard->_families[jj]);
+    _prepareCommands.insert(_prepareCommands.end(), shard->_prepareCommands.begin(), shard->_prepareCommands.end());
+    _collectionNames.insert(_collectionNames.end(), shard->_collectionNames.begin(), shard->_collectionNames.end());
+    _collectionQueries.insert(_collectionQueries.end(), shard->_collectionQueries.begin(), shard->_collectionQueries.end());
+  }
+}
+
+void Content::Private::runPrepareCommands(const Private* previous) const
+{
+  for(vector<string>::const_iterator iter = _prepareCommands.begin();
+      iter != _prepareCommands.end();
+      ++iter)
+  {
+    if(previous == NULL ||
+       std::find(previous->_prepareCommands.begin(), previous->_prepareCommands.end(), *iter) == previous->_prepareCommands.end())
+      CommandQueue::prepare().run(*iter);
+  }
+}
+
+bool Content::Private::isShardDirectory(const string& path)
+{
+  return !path.empty() && path[path.size() - 1] == '/';
+}
+
+void Content::Private::listCatalogs(const string& dataFile, vector<string>& catalogs)
+{
+  catalogs.clear();
+  if(isShardDirectory(dataFile))
+    CatalogReader::list(dataFile, ".csv", catalogs);
+  else
+    catalogs.push_back(dataFile);
+}
+
+void Content::Private::addEdit(const CatalogJournal::Edit& edit, const GameTable* base, unsigned int row, const MacroExpander& macros, GameTable& games)
+{
+  const vector<string>& fields = edit.fields;
+  const vector<bool>& changed = edit.changed;
+
+  vector<unsigned int> typeIds;
+  if(changed[CatalogJournal::TYPES])
+  {
+    vector<string_view> types;
+    CatalogReader::split(fields[CatalogJournal::TYPES], '%', types);
+    for(vector<string_view>::const_iterator iter = types.begin(); iter != types.end(); ++iter)
+      typeIds.push_back(FacetDictionary::types().intern(*iter));
+  }
+  else
+  {
+    FacetIds types = base->types(row);
+    typeIds.assign(types.begin(), types.end());
+  }
+
+  vector<unsigned int> familyIds;
+  if(changed[CatalogJournal::FAMILY])
+  {
+    if(!fields[CatalogJournal::FAMILY].empty())
+      familyIds.push_back(FacetDictionary::families().intern(fields[CatalogJournal::FAMILY]));
+  }
+  else
+  {
+    FacetIds families = base->families(row);
+    familyIds.assign(families.begin(), families.end());
+  }
+
+  string artwork, command, unixified;
+  if(changed[CatalogJournal::ARTWORK])
+    macros.expand(fields[CatalogJournal::ARTWORK], artwork);
+  else
+    artwork = base->picturePath(row);
+  if(changed[CatalogJournal::COMMAND])
+  {
+    unixify(fields[CatalogJournal::COMMAND], unixified);
+    macros.expand(unixified, command);
+  }
+  else
+  {
+    command = base->commandLine(row);
+  }
+
+  games.addGame(changed[CatalogJournal::TITLE] ? string_view(fields[CatalogJournal::TITLE]) : base->name(row),
+                changed[CatalogJournal::SHORT_TITLE] ? string_view(fields[CatalogJournal::SHORT_TITLE]) : base->shortName(row),
+                changed[CatalogJournal::SORT_KEY] ? string_view(fields[CatalogJournal::SORT_KEY]) : base->sortKey(row),
+                typeIds,
+                changed[CatalogJournal::DEVICE] ? FacetDictionary::devices().intern(fields[CatalogJournal::DEVICE]) : base->device(row),
+                changed[CatalogJournal::PLAYERS] ? parseNumPlayers(fields[CatalogJournal::PLAYERS]) : base->maxPlayers(row),
+                familyIds,
+                artwork,
+                command);
+}
+
+void Content::Private::applyJournal(CatalogJournal& journal, const string& dataFile)
+{
+  const vector<CatalogJournal::Edit>& edits = journal.edits();
+  if(edits.empty())
+    return;
+
+  // A catalog file that can't be read has neither games nor macros
+  vector<string> catalogs;
+  listCatalogs(dataFile, catalogs);
+  journal.resolve(catalogs);
+  const MacroExpander& macros = journal.macros();
+
+  unordered_multimap<string_view, unsigned int> editsByKey;
+  unsigned int numIgnored(0);
+  for(unsigned int ii = 0; ii < edits.size(); ++ii)
+  {
+    if(edits[ii].ignored)
+      ++numIgnored;
+    else
+      editsByKey.insert(make_pair(string_view(edits[ii].sortKey), ii));
+  }
+
+  // Edited games are removed, changed ones come back as new games
+  GameTable added;
+  vector<bool> removed(_games.size(), false);
+  unsigned int numRemoved(0);
+  for(unsigned int ii = 0; ii < _games.size(); ++ii)
+  {
+    pair<unordered_multimap<string_view, unsigned int>::const_iterator,
+         unordered_multimap<string_view, unsigned int>::const_iterator> found = editsByKey.equal_range(_games.sortKey(ii));
+    for(; found.first != found.second; ++found.first)
+    {
+      const CatalogJournal::Edit& edit = edits[found.first->second];
+      if(edit.device != FacetDictionary::devices().value(_games.device(ii)))
+        continue;
+      removed[ii] = true;
+      ++numRemoved;
+      if(edit.kind == CatalogJournal::Edit::CHANGED)
+        addEdit(edit, &_games, ii, macros, added);
+      break;
+    }
+  }
+  for(unsigned int ii = 0; ii < edits.size(); ++ii)
+  {
+    if(edits[ii].kind == CatalogJournal::Edit::ADDED && !edits[ii].ignored)
+      addEdit(edits[ii], NULL, 0, macros, added);
+  }
+
+  // The new games are sorted among themselves, then each one goes where a
+  // binary search of the catalog puts it: only the keys on the search path
+  // are computed
+  vector<string> keys(added.size());
+  vector<string_view> keyViews;
+  vector<unsigned int> sorted(added.size());
+  for(unsigned int ii = 0; ii < added.size(); ++ii)
+  {
+    Collation::key(Game(&added, ii), keys[ii]);
+    keyViews.push_back(keys[ii]);
+    sorted[ii] = ii;
+  }
+  Collation::sort(keyViews, sorted);
+
+  unsigned int numGames = _games.size();
+  vector<unsigned int> order;
+  order.reserve(numGames - numRemoved + added.size());
+  string key;
+  unsigned int row(0);
+  for(unsigned int ii = 0; ii < sorted.size(); ++ii)
+  {
+    // After the games of equal key, as if the journal followed the catalog
+    unsigned int first(row);
+    unsigned int last(numGames);
+    while(first < last)
+    {
+      unsigned int middle = first + (last - first) / 2;
+      Collation::key(Game(&_games, middle), key);
+      if(key.compare(keys[sorted[ii]]) <= 0)
+        first = middle + 1;
+      else
+        last = middle;
+    }
+    for(; row < first; ++row)
+    {
+      if(!removed[row])
+        order.push_back(row);
+    }
+    order.push_back(numGames + sorted[ii]);
+  } // end for(unsigned int ii = 0; ii < sorted.size(); ++ii)
+  for(; row < numGames; ++row)
+  {
+    if(!removed[row])
+      order.push_back(row);
+  }
+
+  _games.append(added);
+  _games.reorder(order);
+  _games.shrink();
+
+  // Journal games are not catalog rows: nothing to reuse on reload
+  vector<uint64_t> rowKeys(order.size(), 0);
+  for(unsigned int ii = 0; ii < order.size(); ++ii)
+  {
+    if(order[ii] < numGames)
+      rowKeys[ii] = _rowKeys[order[ii]];
+  }
+  _rowKeys.swap(rowKeys);
+
+  // Facet values may have lost their last game
+  if(numRemoved > 0)
+  {
+    _types.clear();
+    _typeUsed.clear();
+    _devices.clear();
+    _deviceUsed.clear();
+    _families.clear();
+    _familyUsed.clear();
+    for(unsigned int ii = 0; ii < _games.size(); ++ii)
+      addFacets(Game(&_games, ii), _types, _typeUsed, _devices, _deviceUsed, _families, _familyUsed);
+  }
+  else
+  {
+    for(unsigned int ii = 0; ii < added.size(); ++ii)
+      addFacets(Game(&added, ii), _types, _typeUsed, _devices, _deviceUsed, _families, _familyUsed);
+  }
+
+  if(!IsQuiet)
+    cout << "Journal: " << journal.numRecords() << " records, "
+         << added.size() << " games added or changed, "
+         << numRemoved << " replaced or removed, "
+         << numIgnored << " edits ignored" << endl;
+}
+
+void Content::Private::indexRows()
+{
+  _parsedRows.clear();
+  for(unsigned int ii = 0; ii < _rowKeys.size(); ++ii)
+    _parsedRows[_rowKeys[ii]] = ii;
+}
+
+bool Content::Private::loadCache(const CatalogCache& cache)
+{
+  return cache.load(_games, _rowKeys, _types, _devices, _families, _prepareCommands, _collectionNames, _collectionQueries);
+}
+
+bool Content::Private::saveCache(const CatalogCache& cache) const
+{
+  return cache.save(_games, _rowKeys, _types, _devices, _families, _prepareCommands, _collectionNames, _collectionQueries);
+}
+
+void Content::Private::keepFilters(const Private& other)
+{
+  // Facet values are compared by id: FacetDictionary ids are kept across loads
+  _currentType = -1;
+  _currentTypeString.clear();
+  if(other._currentType >= 0)
+  {
+    vector<unsigned int>::const_iterator found = std::find(_types.begin(), _types.end(), other._types[other._currentType]);
+    if(found != _types.end())
+    {
+      _currentType = found - _types.begin();
+      _currentTypeString = other._currentTypeString;
+    }
+  }
+
+  _currentDevice = -1;
+  _currentDeviceString.clear();
+  if(other._currentDevice >= 0)
+  {
+    vector<unsigned int>::const_iterator found = std::find(_devices.begin(), _devices.end(), other._devices[other._currentDevice]);
+    if(found != _devices.end())
+    {
+      _currentDevice = found - _devices.begin();
+      _currentDeviceString = other._currentDeviceString;
+    }
+  }
+
+  _currentMinPlayers = other._currentMinPlayers;
+  _currentMinPlayersString = other._currentMinPlayersString;
+
+  // Collections are compared by name, queries evaluated again
+  _currentCollection = -1;
+  _currentCollectionString.clear();
+  if(other._currentCollection >= 0)
+  {
+    vector<string>::const_iterator found = std::find(_collectionNames.begin(), _collectionNames.end(), other._currentCollectionString);
+    if(found != _collectionNames.end())
+    {
+      _currentCollection = found - _collectionNames.begin();
+      _currentCollectionString = other._currentCollectionString;
+    }
+  }
+  _query = other._query;
+  if(!_query.empty())
+  {
+    _query.evaluate(_index, _names, _queryGames);
+    _currentCollectionString = _query.text();
+  }
+
+  _sortOrder = other._sortOrder;
+  applySortOrder();
+
+  _cube.setCapacity(other._cube.capacity());
+
+  _searching = other._searching;
+  _searchText = other._searchText;
+  if(_searching)
+    restartSearch();
+
+  _currentFamily = -1;
+  _currentFamilyString.clear();
+  if(other._currentFamily >= 0)
+  {
+    vector<unsigned int>::const_iterator found = std::find(_families.begin(), _families.end(), other._families[other._currentFamily]);
+    if(found != _families.end())
+    {
+      _currentFamily = found - _families.begin();
+      _currentFamilyString = other._currentFamilyString;
+    }
+  }
+}
+
+unsigned int Content::Private::parseNumPlayers(string_view numPlayers)
+{
+  unsigned int res(1);
+  from_chars(numPlayers.data(), numPlayers.data() + numPlayers.size(), res);
+  return res;
+}
+
+class Content::Reloader
+{
+  public:
+    Reloader(Content& content);
+    ~Reloader();
+
+    void start(const string& dataFile, const string& cacheFile, const string& journalFile);
+    void stop();
+    void run();
+
+    Content& _content;
+    string _dataFile;
+    string _cacheFile;
+    string _journalFile;
+    CatalogWatcher _watcher;
+    thread _thread;
+    mutex _lock;
+    condition_variable _released;
+    bool _stopping;
+    // Built by the reloading thread, waiting for publishReloadedCatalog()
+    Private* _pending;
+    // Replaced by the last published catalog, until releasePreviousCatalog()
+    Private* _previous;
+};
+
+Content::Reloader::Reloader(Content& content):
+  _content(content),
+  _dataFile(),
+  _cacheFile(),
+  _journalFile(),
+  _watcher(),
+  _thread(),
+  _lock(),
+  _released(),
+  _stopping(false),
+  _pending(NULL),
+  _previous(NULL)
+{}
+
+Content::Reloader::~Reloader()
+{
+  stop();
+  delete _pending;
+  delete _previous;
+}
+
+void Content::Reloader::start(const string& dataFile, const string& cacheFile, const string& journalFile)
+{
+  stop();
+
+  _dataFile = dataFile;
+  _cacheFile = cacheFile;
+  _journalFile = journalFile;
+  if(!_watcher.watch(_dataFile, _journalFile))
+    return;
+
+  _stopping = false;
+  _thread = thread(&Content::Reloader::run, this);
+}
+
+void Content::Reloader::stop()
+{
+  {
+    lock_guard<mutex> lock(_lock);
+    _stopping = true;
+  }
+  _released.notify_all();
+  if(_thread.joinable())
+    _thread.join();
+  _watcher.stop();
+}
+
+void Content::Reloader::run()
+{
+  while(true)
+  {
+    {
+      lock_guard<mutex> lock(_lock);
+      if(_stopping)
+        return;
+    }
+
+    if(!_watcher.waitForChange(500))
+      continue;
+
+    // Let the editor finish writing
+    while(_watcher.waitForChange(200))
+    {}
+
+    // _content.d is only replaced once this catalog is published
+    Private* catalog = new Private;
+    CatalogJournal journal(_journalFile);
+    journal.load();
+    if(Private::isShardDirectory(_dataFile))
+    {
+      // Unchanged shards come from their cache
+      catalog->loadShards(_dataFile, _content.d);
+      catalog->applyJournal(journal, _dataFile);
+      catalog->buildIndexes();
+    }
+    else
+    {
+      // Read, not mapped: the file may be rewritten while it is parsed
+      CatalogReader reader;
+      if(!reader.open(_dataFile, true))
+      {
+        delete catalog;
+        continue;
+      }
+
+      // Still valid when only the journal changed
+      CatalogCache cache(_cacheFile);
+      cache.identify(_dataFile, reader.data(), reader.size());
+      if(catalog->loadCache(cache))
+      {
+        catalog->runPrepareCommands(_content.d);
+      }
+      else
+      {
+        catalog->loadFile(reader, _content.d);
+        catalog->sortGames();
+        catalog->saveCache(cache);
+      }
+      catalog->applyJournal(journal, _dataFile);
+      catalog->buildIndexes();
+    }
+
+    if(!IsQuiet)
+      cout << "Catalog reloaded: " << catalog->_games.size() << " games" << endl;
+
+    unique_lock<mutex> lock(_lock);
+    if(_stopping)
+    {
+      delete catalog;
+      return;
+    }
+    _pending = catalog;
+    while(!_stopping && (_pending != NULL || _previous != NULL))
+      _released.wait(lock);
+  } // end while(true)
+}
+
+Content::Content():
+  d(new Private),
+  _reloader(NULL)
+{
+  _reloader = new Reloader(*this);
+}
+
+Content::~Content()
+{
+  delete _reloader;
+  delete d;
+}
+
+void Content::startAddingGames()
+{
+  d->reset();
+}
+
+void Content::addGame(const Game& game)
+{
+  d->_games.addGame(*game.getTable(), game.getRow());
+  d->_rowKeys.push_back(0);
+
+  Private::addFacets(game,
+                     d->_types, d->_typeUsed,
+                     d->_devices, d->_deviceUsed,
+                     d->_families, d->_familyUsed);
+}
+
+void Content::stopAddingGames()
+{
+  d->finishLoading();
+}
+
+const string& Content::nextGameType()
+{
+  d->prepareFacet(FacetIndex::TYPE);
+  d->_currentType = Private::nextValue(d->_currentType, d->_typeCounts);
+
+  if(d->_currentType < 0)
+  {
+    d->_currentTypeString.clear();
+  }
+  else
+  {
+    d->_currentTypeString = FacetDictionary::types().value(d->_types[d->_currentType]);
+  }
+
+  d->regenerateSelection(FacetIndex::TYPE);
 
   return d->_currentTypeString;
 }
 
-const string& Content::previousDevice()
+const string& Content::nextDevice()
 {
+  d->prepareFacet(FacetIndex::DEVICE);
+  d->_currentDevice = Private::nextValue(d->_currentDevice, d->_deviceCounts);
+
   if(d->_currentDevice < 0)
   {
-    d->_currentDevice = d->_devices.size() - 1;
+    d->_currentDeviceString.clear();
+  }
+  else
+  {
+    d->_currentDeviceString = FacetDictionary::devices().value(d->_devices[d->_currentDevice]);
+  }
+
+  d->regenerateSelection(FacetIndex::DEVICE);
+
+  return d->_currentDeviceString;
+}
+
+const string& Content::nextMultiplayer()
+{
+  d->prepareFacet(FacetIndex::PLAYERS);
+  do
+  {
+    switch(d->_currentMinPlayers)
+    {
+    case 2:
+        d->_currentMinPlayers = 3;
+        d->_currentMinPlayersString = "3P";
+        break;
+
+    case 3:
+        d->_currentMinPlayers = 1;
+        d->_currentMinPlayersString = "1P/2P/3P";
+        break;
+
+    default:
+        d->_currentMinPlayers = 2;
+        d->_currentMinPlayersString = "2P/3P";
+        break;
+    }
+  } while(d->_currentMinPlayers > 1 && d->playerCount(d->_currentMinPlayers) == 0);
+
+  d->regenerateSelection(FacetIndex::PLAYERS);
+
+  return d->_currentMinPlayersString;
+}
+
+const string& Content::nextGameFamily()
+{
+  d->prepareFacet(FacetIndex::FAMILY);
+  d->_currentFamily = Private::nextValue(d->_currentFamily, d->_familyCounts);
+
+  if(d->_currentFamily < 0)
+  {
+    d->_currentFamilyString.clear();
+  }
+  else
+  {
+    d->_currentFamilyString = FacetDictionary::families().value(d->_families[d->_currentFamily]);
+  }
+
+  d->regenerateSelection(FacetIndex::FAMILY);
+
+  return d->_currentFamilyString;
+}
+
+
+
+
+const string& Content::previousGameType()
+{
+  d->prepareFacet(FacetIndex::TYPE);
+  d->_currentType = Private::previousValue(d->_currentType, d->_typeCounts);
+
+  if(d->_currentType < 0)
+  {
+    d->_currentTypeString.clear();
   }
   else
   {
-    --d->_currentDevice;
+    d->_currentTypeString = FacetDictionary::types().value(d->_types[d->_currentType]);
   }
 
+  d->regenerateSelection(FacetIndex::TYPE);
+
+  return d->_currentTypeString;
+}
+
+const string& Content::previousDevice()
+{
+  d->prepareFacet(FacetIndex::DEVICE);
+  d->_currentDevice = Private::previousValue(d->_currentDevice, d->_deviceCounts);
+
   if(d->_currentDevice < 0)
   {
-    d->_currentDevice = -1;
     d->_currentDeviceString.clear();
   }
   else
   {
-    d->_currentDeviceString = d->_devices[d->_currentDevice];
+    d->_currentDeviceString = FacetDictionary::devices().value(d->_devices[d->_currentDevice]);
   }
 
-  d->regenerateSelection();
+  d->regenerateSelection(FacetIndex::DEVICE);
 
   return d->_currentDeviceString;
 }
@@ -715,153 +1876,507 @@ const string& Content::previousMultiplayer()
 
 const string& Content::previousGameFamily()
 {
+  d->prepareFacet(FacetIndex::FAMILY);
+  d->_currentFamily = Private::previousValue(d->_currentFamily, d->_familyCounts);
+
   if(d->_currentFamily < 0)
   {
-    d->_currentFamily = d->_families.size() - 1;
+    d->_currentFamilyString.clear();
   }
   else
   {
-    --d->_currentFamily;
+    d->_currentFamilyString = FacetDictionary::families().value(d->_families[d->_currentFamily]);
   }
 
-  if(d->_currentFamily < 0)
+  d->regenerateSelection(FacetIndex::FAMILY);
+
+  return d->_currentFamilyString;
+}
+
+
+
+const string& Content::nextCollection()
+{
+  // Collections without games under the other filters are skipped
+  d->_query.clear();
+  d->prepareCollections();
+  do
   {
-    d->_currentFamily = -1;
-    d->_currentFamilyString.clear();
+    ++d->_currentCollection;
+  } while(d->_currentCollection < (int) d->_collections.size() && d->_collectionCounts[d->_currentCollection] == 0);
+
+  if(d->_currentCollection >= (int) d->_collections.size())
+  {
+    d->_currentCollection = -1;
+    d->_currentCollectionString.clear();
+  }
+  else
+  {
+    d->_currentCollectionString = d->_collectionNames[d->_currentCollection];
+  }
+
+  d->regenerateSelection();
+
+  return d->_currentCollectionString;
+}
+
+const string& Content::previousCollection()
+{
+  d->_query.clear();
+  d->prepareCollections();
+  if(d->_currentCollection < 0)
+  {
+    d->_currentCollection = d->_collections.size() - 1;
+  }
+  else
+  {
+    --d->_currentCollection;
+  }
+  while(d->_currentCollection >= 0 && d->_collectionCounts[d->_currentCollection] == 0)
+    --d->_currentCollection;
+
+  if(d->_currentCollection < 0)
+  {
+    d->_currentCollection = -1;
+    d->_currentCollectionString.clear();
   }
   else
   {
-    d->_currentFamilyString = d->_families[d->_currentFamily];
+    d->_currentCollectionString = d->_collectionNames[d->_currentCollection];
   }
 
   d->regenerateSelection();
 
+  return d->_currentCollectionString;
+}
+
+const string& Content::currentCollection() const
+{
+  return d->_currentCollectionString;
+}
+
+bool Content::setQuery(const string& query, string& message)
+{
+  // Blanks alone are no query either
+  FilterQuery parsed;
+  if(query.find_first_not_of(" \t\n\v\f\r") != string::npos && !parsed.parse(query, message))
+    return false;
+
+  // Selections of the previous query are out of date
+  d->_cube.clear();
+  d->_query = parsed;
+  d->_queryGames.resize(0);
+  if(!d->_query.empty())
+    d->_query.evaluate(d->_index, d->_names, d->_queryGames);
+  d->_currentCollection = -1;
+  d->_currentCollectionString = d->_query.text();
+
+  d->regenerateSelection();
+  return true;
+}
+
+void Content::setFacetCubeCapacity(size_t capacity)
+{
+  d->_cube.setCapacity(capacity);
+}
+
+FacetCube::Stats Content::facetCubeStats() const
+{
+  return d->_cube.stats();
+}
+
+const GameTable& Content::games() const
+{
+  return d->_games;
+}
+
+Selection Content::currentSelection() const
+{
+  if(d->_searching)
+    return Selection(&d->_games, d->_searchResult, d->_searchRanked, d->_searchSections);
+  return Selection(&d->_games, d->_selectedGames, false, d->_selectedSections);
+}
+
+const string& Content::currentGameType() const
+{
+  return d->_currentTypeString;
+}
+
+const string& Content::currentDevice() const
+{
+  return d->_currentDeviceString;
+}
+
+const string& Content::currentMultiplayer() const
+{
+  return d->_currentMinPlayersString;
+}
+
+const string& Content::currentGameFamily() const
+{
   return d->_currentFamilyString;
 }
 
+unsigned int Content::currentGameTypeCount() const
+{
+  return d->currentCount(FacetIndex::TYPE);
+}
 
+unsigned int Content::currentDeviceCount() const
+{
+  return d->currentCount(FacetIndex::DEVICE);
+}
 
-const vector<Game*>& Content::currentSelection() const
+unsigned int Content::currentMultiplayerCount() const
 {
-  return d->_selectedGames;
+  return d->currentCount(FacetIndex::PLAYERS);
 }
 
-bool Content::init()
+unsigned int Content::currentGameFamilyCount() const
+{
+  return d->currentCount(FacetIndex::FAMILY);
+}
+
+unsigned int Content::currentCollectionCount() const
+{
+  // The collection restricts the counts of every facet
+  return d->currentCount(FacetIndex::TYPE);
+}
+
+void Content::setSortOrder(SortOrder order)
+{
+  // The orders are ready: only the selection is listed again
+  d->_sortOrder = order;
+  d->applySortOrder();
+  if(!d->findCachedSelection())
+    d->projectSelection();
+}
+
+Content::SortOrder Content::sortOrder() const
+{
+  return d->_sortOrder;
+}
+
+Content::SortOrder Content::nextSortOrder()
+{
+  setSortOrder((SortOrder) ((d->_sortOrder + 1) % NUM_SORT_ORDERS));
+  return d->_sortOrder;
+}
+
+void Content::startSearch()
+{
+  d->_searching = true;
+  d->_searchText.clear();
+  d->restartSearch();
+  d->applySearch();
+}
+
+void Content::stopSearch()
+{
+  d->_searching = false;
+  d->_searchText.clear();
+  d->_searchResult.reset();
+  d->_searchSections.reset();
+}
+
+bool Content::isSearching() const
+{
+  return d->_searching;
+}
+
+const string& Content::searchText() const
+{
+  return d->_searchText;
+}
+
+void Content::appendToSearch(char character)
+{
+  if(!d->_searching)
+    return;
+
+  // The range of the previous prefix is narrowed
+  d->_searchText += character;
+  Collation::normalize(string_view(&character, 1), d->_searchKey);
+  unsigned int first = d->_searchRanges[d->_searchRanges.size() - 2];
+  unsigned int last = d->_searchRanges.back();
+  d->_names.narrow(d->_searchKey, first, last);
+  d->_searchRanges.push_back(first);
+  d->_searchRanges.push_back(last);
+
+  d->applySearch();
+}
+
+void Content::removeFromSearch()
+{
+  if(!d->_searching || d->_searchText.empty())
+    return;
+
+  d->_searchText.erase(d->_searchText.size() - 1);
+  d->_searchKey.clear();
+  Collation::normalize(d->_searchText, d->_searchKey);
+  d->_searchRanges.resize(d->_searchRanges.size() - 2);
+
+  d->applySearch();
+}
+
+unsigned int Content::findPosition(const Game& game) const
+{
+  // Lower bound
+  unsigned int first(0);
+  unsigned int count(d->_games.size());
+  while(count > 0)
+  {
+    unsigned int step = count / 2;
+    if(Game(&d->_games, first + step) < game)
+    {
+      first += step + 1;
+      count -= step + 1;
+    }
+    else
+    {
+      count = step;
+    }
+  }
+  return first < d->_games.size() ? d->_games.position(first) : first;
+}
+
+bool Content::addGames(const string& dataFile)
 {
+  CatalogReader reader;
+  if(!reader.open(dataFile))
+    return false;
+  d->loadFile(reader, NULL);
+  return true;
+}
 
-#define ADDGAME2(title, shortName, sortKey, types, device, numPlayers, family, artwork, command)\
-{\
-  Game game;\
-  game.setName(title);\
-  game.setShortName(shortName);\
-  game.setSortKey(sortKey);\
-  for(list<string>::const_iterator iter = types.begin(); iter != types.end(); ++iter) game.addGameType(*iter);\
-  game.setDevice(device);\
-  game.setNumPlayers(numPlayers);\
-  game.addGameFamily(family);\
-  game.setPicturePath(artwork);\
-  game.setCommandLine(command);\
-  addGame(game);\
+bool Content::init()
+{
+  // Catalog shards, when there are any, replace the catalog file
+  vector<string> shards;
+  if(CatalogReader::list(RESOURCE_PATH(SHARD_DIRECTORY), ".csv", shards) && !shards.empty())
+    return init(RESOURCE_PATH(SHARD_DIRECTORY "/"), string(), RESOURCE_PATH(SHARD_DIRECTORY "/" JOURNAL_FILE));
+  return init(RESOURCE_PATH(DATA_FILE), RESOURCE_PATH(CACHE_FILE), RESOURCE_PATH(JOURNAL_FILE));
 }
 
+bool Content::init(const string& dataFile, const string& cacheFile, const string& journalFile)
+{
   startAddingGames();
 
-  loadFile();
+  // A long journal is written into the catalog first. The catalog is then
+  // parsed again, once.
+  CatalogJournal journal(journalFile);
+  journal.load();
+  if(journal.numRecords() >= JOURNAL_COMPACTION_THRESHOLD)
+  {
+    vector<string> catalogs;
+    Private::listCatalogs(dataFile, catalogs);
+    if(!journal.compact(catalogs) && !IsQuiet)
+      cout << "Journal " << journalFile << " could not be written into the catalog" << endl;
+    journal.load();
+  }
+
+  if(Private::isShardDirectory(dataFile))
+  {
+    d->loadShards(dataFile, NULL);
+    d->applyJournal(journal, dataFile);
+    d->buildIndexes();
+  }
+  else
+  {
+    CatalogReader reader;
+    reader.open(dataFile);
+
+    CatalogCache cache(cacheFile);
+    cache.identify(dataFile, reader.data(), reader.size());
+    if(d->loadCache(cache))
+    {
+      // Sorted already: only PREPARE lines remain to be run
+      d->runPrepareCommands(NULL);
+    }
+    else
+    {
+      if(reader.isOpen())
+        d->loadFile(reader, NULL);
 
-  stopAddingGames();
+      // The cache holds the catalog alone, the journal is replayed over it
+      d->sortGames();
+      d->saveCache(cache);
+    }
+    d->applyJournal(journal, dataFile);
+    d->buildIndexes();
+    reader.close();
+  }
 
-  if(!PixBox::instance()->isQuiet())
+  if(!IsQuiet)
   {
     cout << "ALL GAMES" << endl;
-    for(list<Game*>::const_iterator iter = d->_allGames.begin();
-        iter != d->_allGames.end();
-        ++iter)
+    for(unsigned int ii = 0; ii < d->_games.size(); ++ii)
     {
-      cout << (*iter)->getName().c_str() << endl;
+      cout << d->_games.name(ii) << endl;
     }
     cout << "DONE ALL GAMES" << endl;
   }
 
+  _reloader->start(dataFile, cacheFile, journalFile);
 
   return true;
 }
 
 bool Content::quit()
 {
+  _reloader->stop();
+
+  if(!IsQuiet)
+  {
+    FacetCube::Stats stats = d->_cube.stats();
+    cout << "Facet cube: " << stats.entries << " selections, "
+         << stats.bytes / 1024 << " KB of " << stats.capacity / 1024 << " KB, "
+         << stats.hits << " hits, " << stats.misses << " misses, "
+         << stats.evictions << " evictions" << endl;
+  }
   return true;
 }
 
-
-void Content::loadFile()
+bool Content::publishReloadedCatalog()
 {
-  ifstream file;
-  file.open(RESOURCE_PATH(DATA_FILE).c_str());
+  unique_lock<mutex> lock(_reloader->_lock, try_to_lock);
+  if(!lock.owns_lock() || _reloader->_pending == NULL || _reloader->_previous != NULL)
+    return false;
 
-  char line[1000];
-  string lineStr;
+  Private* catalog = _reloader->_pending;
+  _reloader->_pending = NULL;
 
-  list< pair<string,string> > macros;
+  catalog->keepFilters(*d);
+  catalog->regenerateSelection();
+
+  _reloader->_previous = d;
+  d = catalog;
+  return true;
+}
 
-  while(file.good())
+void Content::releasePreviousCatalog()
+{
+  Private* previous(NULL);
   {
-    file.getline(line, 1000);
-    lineStr = line;
+    lock_guard<mutex> lock(_reloader->_lock);
+    previous = _reloader->_previous;
+    _reloader->_previous = NULL;
+  }
+  delete previous;
+  _reloader->_released.notify_all();
+}
+
+
+void Content::Private::loadFile(CatalogReader& reader, const Private* previous, unsigned int numThreads, bool runCommands)
+{
+  reader.rewind();
+
+  // MACRO, PREPARE and COLLECTION lines are handled in file order, game rows are only
+  // collected. A new set of macros is started when a MACRO line follows
+  // game rows, so that each row is expanded with the macros defined above it.
+  vector<MacroExpander> macros(1);
+  vector<uint64_t> macroKeys(1, 14695981039346656037ULL);
+  vector<Row> rows;
+  bool rowsSinceMacro(false);
 
-    list<string> split = Private::split(lineStr, ';');
-    if(!split.empty())
+  string_view line;
+  vector<string_view> split;
+
+  while(reader.nextLine(line))
+  {
+    string_view first = line.substr(0, line.find(';'));
+    if(line.empty())
+    {
+      // Ignore
+    }
+    else if(first == "MACRO")
     {
-      string first = split.front();
-      if(first == "MACRO")
+      CatalogReader::split(line, ';', split);
+      if(split.size() > 2)
       {
-        split.pop_front();
-        string macroName, macroValue;
-        if(!split.empty())
+        if(rowsSinceMacro)
         {
-          macroName = split.front();
-          split.pop_front();
+          MacroExpander current(macros.back());
+          macros.push_back(current);
+          macroKeys.push_back(macroKeys.back());
+          rowsSinceMacro = false;
         }
-        if(!split.empty())
-        {
-          macroValue = split.front();
-          macroValue = Private::macroSubstitution(macros, macroValue);
-          macros.push_back(pair<string, string>(macroName, macroValue));
-        }
-      }
-      else if(first == "PREPARE")
-      {
-        split.pop_front();
-        system(split.front().c_str());
+        macros.back().define(split[1], split[2]);
+        macroKeys.back() = hash(line, macroKeys.back());
       }
-      else if(!first.empty() && first[0] == '#')
+    }
+    else if(first == "PREPARE")
+    {
+      CatalogReader::split(line, ';', split);
+      if(split.size() > 1)
       {
-        // Ignore
+        // Run while parsing goes on. A reload only runs new commands.
+        _prepareCommands.push_back(string(split[1]));
+        if(runCommands &&
+           (previous == NULL ||
+            std::find(previous->_prepareCommands.begin(), previous->_prepareCommands.end(), _prepareCommands.back()) == previous->_prepareCommands.end()))
+          CommandQueue::prepare().run(_prepareCommands.back());
       }
-      else
+    }
+    else if(first == "COLLECTION")
+    {
+      // Evaluated once the indexes are built
+      CatalogReader::split(line, ';', split);
+      if(split.size() > 2)
       {
-        string title,
-            shortTitle,
-            sortKey,
-            device,
-            family,
-            numPlayers,
-            artwork,
-            command;
-        list<string> types;
-        if(!split.empty()) {title = split.front(); split.pop_front();}
-        if(!split.empty()) {shortTitle = split.front(); split.pop_front();}
-        if(!split.empty()) {sortKey = split.front(); split.pop_front();}
-        if(!split.empty()) {string typesStr = split.front(); types = d->split(typesStr, '%'); split.pop_front();}
-        if(!split.empty()) {device = split.front(); split.pop_front();}
-        if(!split.empty()) {numPlayers = split.front(); split.pop_front();}
-        if(!split.empty()) {family = split.front(); split.pop_front();}
-        if(!split.empty()) {artwork = split.front(); artwork = Private::macroSubstitution(macros, artwork); split.pop_front();}
-        if(!split.empty()) {command = split.front(); command=Private::unixify(command); command = Private::macroSubstitution(macros, command);}
-        ADDGAME2(title, shortTitle, sortKey, types, device, std::stoi(numPlayers), family, artwork, command);
+        _collectionNames.push_back(string(split[1]));
+        _collectionQueries.push_back(string(split[2]));
       }
-    } // end if(!split.empty())
+    }
+    else if(!first.empty() && first[0] == '#')
+    {
+      // Ignore
+    }
+    else
+    {
+      Row row = {line, (unsigned int) macros.size() - 1, hash(line, macroKeys.back())};
+      rows.push_back(row);
+      rowsSinceMacro = true;
+    }
   }
 
-  file.close();
-}
+  // Game rows are parsed by chunks of consecutive rows, one per core
+  if(numThreads == 0)
+    numThreads = thread::hardware_concurrency();
+  if(numThreads == 0)
+    numThreads = 1;
+  unsigned int numChunks = rows.size() / MIN_ROWS_PER_CHUNK;
+  if(numChunks > numThreads)
+    numChunks = numThreads;
+  if(numChunks == 0)
+    numChunks = 1;
+
+  vector<Chunk> chunks(numChunks);
+  for(unsigned int ii = 0; ii < numChunks; ++ii)
+  {
+    chunks[ii].begin = rows.data() + rows.size() * ii / numChunks;
+    chunks[ii].end = rows.data() + rows.size() * (ii + 1) / numChunks;
+    chunks[ii].macros = &macros;
+    chunks[ii].previousGames = previous != NULL ? &previous->_games : NULL;
+    chunks[ii].parsedRows = previous != NULL ? &previous->_parsedRows : NULL;
+  }
 
+  vector<thread> threads;
+  for(unsigned int ii = 1; ii < numChunks; ++ii)
+    threads.push_back(thread(parseChunk, &chunks[ii]));
+  parseChunk(&chunks[0]);
+  for(unsigned int ii = 0; ii < threads.size(); ++ii)
+    threads[ii].join();
+
+  // Chunks are merged in file order, sorting happens in finishLoading()
+  unsigned int reused(0);
+  _games.reserve(_games.size() + rows.size());
+  for(unsigned int ii = 0; ii < numChunks; ++ii)
+  {
+    reused += chunks[ii].reused;
+    mergeChunk(chunks[ii]);
+  }
 
+  if(previous != NULL && !IsQuiet)
+    cout << rows.size() - reused << " catalog rows parsed, " << reused << " unchanged" << endl;
+}
@@ -1,52 +1,45 @@
 #ifndef CONTENT_H
 #define CONTENT_H
 
-#include <list>
 #include <vector>
 #include <string>
+#include <string_view>
 #include "defines.h"
+#include "FacetCube.h"
+#include "GameTable.h"
 
+class Selection;
 
+// No logs on the console, set by PixBox::init()
 extern bool IsQuiet;
 
+// A row of a GameTable. Only valid while the table is.
 class Game
 {
   public:
     Game();
-    Game(const Game&);
-    Game& operator=(const Game&);
-    ~Game();
+    Game(const GameTable* table, unsigned int row);
 
-    void setPosition(unsigned int pos);
+    bool isValid() const;
+    const GameTable* getTable() const;
+    unsigned int getRow() const;
+    // Position in the current sort order
     unsigned int getPosition() const;
 
-    void setName(const std::string& name);
-    const std::string& getName() const;
+    std::string_view getName() const;
+    std::string_view getShortName() const;
+    std::string_view getSortKey() const;
 
-    void setShortName(const std::string& shortName);
-    const std::string& getShortName() const;
-
-    void setSortKey(const std::string& sortKey);
-    const std::string& getSortKey() const;
-
-    void addGameType(const std::string& type);
-    const std::list<std::string>& getGameTypes() const;
-
-    void setDevice(const std::string& device);
+    // Facet values are FacetDictionary ids
+    FacetIds getGameTypeIds() const;
+    unsigned int getDeviceId() const;
     const std::string& getDevice() const;
-
-    void setNumPlayers(unsigned int numPlayers);
     unsigned int getMaxPlayers() const;
     std::string getMaxPlayersString() const;
+    FacetIds getGameFamilyIds() const;
 
-    void addGameFamily(const std::string& family);
-    const std::list<std::string>& getGameFamilies() const;
-
-    void setCommandLine(const std::string& commandLine);
-    const std::string& getCommandLine() const;
-
-    void setPicturePath(const std::string& picturePath);
-    const std::string& getPicturePath() const;
+    std::string_view getCommandLine() const;
+    std::string_view getPicturePath() const;
 
     bool operator<(const Game&) const;
 
@@ -56,10 +49,8 @@ class Game
                  const std::string& family = std::string()) const;
 
   private:
-
-    class Private;
-    Private* d;
-
+    const GameTable* _table;
+    unsigned int _row;
 };
 
 class Content
@@ -70,6 +61,8 @@ class Content
 
     void startAddingGames();
     void addGame(const Game&);
+    // Games and PREPARE lines of a catalog file, the cache left aside
+    bool addGames(const std::string& dataFile);
     void stopAddingGames();
 
     const std::string& nextGameType();
@@ -82,15 +75,91 @@ class Content
     const std::string& previousMultiplayer();
     const std::string& previousGameFamily();
 
-    const std::vector<Game*>& currentSelection() const;
-
+    // Saved collections, from the COLLECTION lines of the catalog: a name
+    // and a FilterQuery, whose games are found once at load. The selection
+    // only holds the games of the current collection, or of the query given
+    // to setQuery() when there is one.
+    const std::string& nextCollection();
+    const std::string& previousCollection();
+    const std::string& currentCollection() const;
+    // False, with the error in message, if query is not a FilterQuery. An
+    // empty or blank query selects all games again.
+    bool setQuery(const std::string& query, std::string& message);
+
+    // Selections of the filter combinations already seen are kept, up to
+    // the capacity in bytes, FACET_CUBE_CAPACITY by default. Statistics
+    // start again with each catalog loaded.
+    void setFacetCubeCapacity(size_t capacity);
+    FacetCube::Stats facetCubeStats() const;
+
+    // Orders the selection can be shown in, the catalog order first
+    enum SortOrder
+    {
+      CATALOG_ORDER,
+      NAME_ORDER,
+      DEVICE_ORDER,
+      PLAYERS_ORDER,
+      NUM_SORT_ORDERS
+    };
+    void setSortOrder(SortOrder order);
+    SortOrder sortOrder() const;
+    SortOrder nextSortOrder();
+
+    // The catalog, sorted: the row of a game is its position in catalog
+    // order. Positions in the current order come from getPosition().
+    const GameTable& games() const;
+    // Rows of the selected games in the current order, valid until they
+    // are reloaded
+    Selection currentSelection() const;
+
+    const std::string& currentGameType() const;
+    const std::string& currentDevice() const;
+    const std::string& currentMultiplayer() const;
+    const std::string& currentGameFamily() const;
+    // Games of the current value of each filter under the others and the
+    // collection, the search aside
+    unsigned int currentGameTypeCount() const;
+    unsigned int currentDeviceCount() const;
+    unsigned int currentMultiplayerCount() const;
+    unsigned int currentGameFamilyCount() const;
+    unsigned int currentCollectionCount() const;
+
+    // Type-ahead search. While searching, the selection only holds the
+    // games whose name starts with the search text, case, accents and
+    // leading article ignored.
+    void startSearch();
+    void stopSearch();
+    bool isSearching() const;
+    const std::string& searchText() const;
+    void appendToSearch(char character);
+    void removeFromSearch();
+
+    // Position of the game in the current order. If the catalog does not
+    // contain it, position of the first game after it in catalog order.
+    unsigned int findPosition(const Game& game) const;
+
+    // The catalog in RESOURCE_PATH, or in the given files. A data path
+    // ending with '/' is a directory of catalog shards, each one cached
+    // next to itself: the cache path is not used then. The CatalogJournal,
+    // if any, is replayed over the catalog, and written into it once it
+    // holds JOURNAL_COMPACTION_THRESHOLD records.
     bool init();
+    bool init(const std::string& dataFile, const std::string& cacheFile, const std::string& journalFile = std::string());
     bool quit();
 
+    // The catalog file and its journal are watched from init() on, and the
+    // catalog reloaded in the background when they change. Call between
+    // frames: returns true when a reloaded catalog replaced the current one,
+    // with the same filters. The games of the previous catalog stay valid
+    // until releasePreviousCatalog().
+    bool publishReloadedCatalog();
+    void releasePreviousCatalog();
+
   private:
-        void loadFile();
     class Private;
     Private* d;
+    class Reloader;
+    Reloader* _reloader;
 };
 
 #endif // CONTENT_H
@@ -0,0 +1,68 @@
+#include "Crc32.h"
+
+#define CRC32_POLYNOMIAL 0xEDB88320u
+
+namespace
+{
+  struct Tables
+  {
+    uint32_t values[8][256];
+
+    Tables()
+    {
+      for(unsigned int ii = 0; ii < 256; ++ii)
+      {
+        uint32_t crc = ii;
+        for(unsigned int bit = 0; bit < 8; ++bit)
+          crc = (crc >> 1) ^ ((crc & 1) ? CRC32_POLYNOMIAL : 0);
+        values[0][ii] = crc;
+      }
+
+      // values[n][b]: CRC of byte b followed by n zero bytes
+      for(unsigned int ii = 0; ii < 256; ++ii)
+      {
+        for(unsigned int slice = 1; slice < 8; ++slice)
+          values[slice][ii] = (values[slice - 1][ii] >> 8) ^ values[0][values[slice - 1][ii] & 0xFF];
+      }
+    }
+  };
+}
+
+const uint32_t (*Crc32::tables())[256]
+{
+  static const Tables tables;
+  return tables.values;
+}
+
+uint32_t Crc32::update(uint32_t crc, const void* data, size_t size)
+{
+  const uint32_t (*table)[256] = tables();
+  const unsigned char* bytes = (const unsigned char*) data;
+  crc = ~crc;
+
+  // Bytes are assembled by hand, so that the result does not depend on
+  // the endianness
+  while(size >= 8)
+  {
+    uint32_t low = crc ^ (bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t) bytes[3] << 24));
+    uint32_t high = bytes[4] | (bytes[5] << 8) | (bytes[6] << 16) | ((uint32_t) bytes[7] << 24);
+    crc = table[7][low & 0xFF] ^
+          table[6][(low >> 8) & 0xFF] ^
+          table[5][(low >> 16) & 0xFF] ^
+          table[4][low >> 24] ^
+          table[3][high & 0xFF] ^
+          table[2][(high >> 8) & 0xFF] ^
+          table[1][(high >> 16) & 0xFF] ^
+          table[0][high >> 24];
+    bytes += 8;
+    size -= 8;
+  }
+
+  while(size > 0)
+  {
+    crc = (crc >> 8) ^ table[0][(crc ^ *bytes) & 0xFF];
+    ++bytes;
+    --size;
+  }
+  return ~crc;
+}
@@ -0,0 +1,20 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 as found in zip and DAT files (IEEE 802.3, reflected). Eight
+// bytes are folded at a time with eight lookup tables ("slicing by 8"),
+// about five times faster than a lookup per byte.
+class Crc32
+{
+  public:
+    // CRC of the data following the data whose CRC is crc, 0 to start
+    static uint32_t update(uint32_t crc, const void* data, size_t size);
+
+  private:
+    static const uint32_t (*tables())[256];
+};
+
+#endif // CRC32_H
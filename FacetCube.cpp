@@ -0,0 +1,80 @@
+#include "FacetCube.h"
+
+using namespace std;
+
+FacetCube::FacetCube(size_t capacity):
+  _entries(),
+  _recent(),
+  _bytes(0),
+  _capacity(capacity),
+  _hits(0),
+  _misses(0),
+  _evictions(0)
+{}
+
+void FacetCube::clear()
+{
+  _entries.clear();
+  _recent.clear();
+  _bytes = 0;
+}
+
+void FacetCube::setCapacity(size_t capacity)
+{
+  _capacity = capacity;
+  evict(_capacity);
+}
+
+size_t FacetCube::capacity() const
+{
+  return _capacity;
+}
+
+bool FacetCube::find(uint64_t key, Rows& rows, Rows& sections)
+{
+  unordered_map<uint64_t, Entry>::iterator found = _entries.find(key);
+  if(found == _entries.end())
+  {
+    ++_misses;
+    return false;
+  }
+
+  ++_hits;
+  _recent.splice(_recent.begin(), _recent, found->second.recent);
+  rows = found->second.rows;
+  sections = found->second.sections;
+  return true;
+}
+
+void FacetCube::insert(uint64_t key, const Rows& rows, const Rows& sections)
+{
+  // The rows, and roughly the map and list nodes
+  size_t bytes = (rows->capacity() + sections->capacity()) * sizeof(unsigned int) +
+                 2 * sizeof(vector<unsigned int>) + sizeof(Entry) + 8 * sizeof(void*);
+  if(bytes > _capacity || _entries.find(key) != _entries.end())
+    return;
+  evict(_capacity - bytes);
+
+  _recent.push_front(key);
+  Entry entry = {rows, sections, bytes, _recent.begin()};
+  _entries[key] = entry;
+  _bytes += bytes;
+}
+
+void FacetCube::evict(size_t capacity)
+{
+  while(_bytes > capacity && !_recent.empty())
+  {
+    unordered_map<uint64_t, Entry>::iterator oldest = _entries.find(_recent.back());
+    _bytes -= oldest->second.bytes;
+    _entries.erase(oldest);
+    _recent.pop_back();
+    ++_evictions;
+  }
+}
+
+FacetCube::Stats FacetCube::stats() const
+{
+  Stats res = {(unsigned int) _entries.size(), _bytes, _capacity, _hits, _misses, _evictions};
+  return res;
+}
@@ -0,0 +1,66 @@
+#ifndef FACETCUBE_H
+#define FACETCUBE_H
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+// Selections already computed, by combination of filter values packed in a
+// 64-bit key, so that coming back to a combination costs a lookup. Once the
+// rows take more than the capacity, the least recently used ones are
+// dropped. Rows are shared with the Selections handed out: they must not be
+// modified once inserted.
+class FacetCube
+{
+  public:
+    typedef std::shared_ptr<std::vector<unsigned int> > Rows;
+
+    struct Stats
+    {
+      unsigned int entries;
+      size_t bytes;
+      size_t capacity;
+      uint64_t hits;
+      uint64_t misses;
+      uint64_t evictions;
+    };
+
+    explicit FacetCube(size_t capacity);
+
+    // Drops the entries, statistics are kept
+    void clear();
+    void setCapacity(size_t capacity);
+    size_t capacity() const;
+
+    // Rows of the selection and first rows of its letters, false if the
+    // combination is not there
+    bool find(uint64_t key, Rows& rows, Rows& sections);
+    void insert(uint64_t key, const Rows& rows, const Rows& sections);
+
+    Stats stats() const;
+
+  private:
+    struct Entry
+    {
+      Rows rows;
+      Rows sections;
+      size_t bytes;
+      std::list<uint64_t>::iterator recent;
+    };
+
+    void evict(size_t capacity);
+
+    std::unordered_map<uint64_t, Entry> _entries;
+    // Most recently used first
+    std::list<uint64_t> _recent;
+    size_t _bytes;
+    size_t _capacity;
+    uint64_t _hits;
+    uint64_t _misses;
+    uint64_t _evictions;
+};
+
+#endif // FACETCUBE_H
@@ -0,0 +1,160 @@
+#include "FacetDictionary.h"
+
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+using namespace std;
+
+class FacetDictionary::Private
+{
+  public:
+    Private();
+    ~Private(){}
+
+    void updateRanks() const;
+
+    // deque: references returned by value() and the keys of _ids stay
+    // valid while interning
+    deque<string> _values;
+    unordered_map<string_view, unsigned int> _ids;
+    mutable vector<unsigned int> _ranks;
+    // Lookups of known values (the common case) share the lock
+    mutable shared_mutex _lock;
+};
+
+namespace
+{
+  class ValueComparator
+  {
+    public:
+      ValueComparator(const deque<string>& values): _values(values) {}
+      bool operator()(unsigned int first, unsigned int second) const
+      {
+        return _values[first] < _values[second];
+      }
+    private:
+      const deque<string>& _values;
+  };
+
+  class RankComparator
+  {
+    public:
+      RankComparator(const vector<unsigned int>& ranks): _ranks(ranks) {}
+      bool operator()(unsigned int first, unsigned int second) const
+      {
+        return _ranks[first] < _ranks[second];
+      }
+    private:
+      const vector<unsigned int>& _ranks;
+  };
+}
+
+FacetDictionary::Private::Private():
+  _values(),
+  _ids(),
+  _ranks(),
+  _lock()
+{}
+
+void FacetDictionary::Private::updateRanks() const
+{
+  if(_ranks.size() == _values.size())
+    return;
+
+  vector<unsigned int> order(_values.size());
+  for(unsigned int ii = 0; ii < order.size(); ++ii)
+    order[ii] = ii;
+  std::sort(order.begin(), order.end(), ValueComparator(_values));
+
+  _ranks.resize(order.size());
+  for(unsigned int ii = 0; ii < order.size(); ++ii)
+    _ranks[order[ii]] = ii;
+}
+
+FacetDictionary::FacetDictionary():
+  d(new Private)
+{}
+
+FacetDictionary::~FacetDictionary()
+{
+  delete d;
+}
+
+FacetDictionary& FacetDictionary::types()
+{
+  static FacetDictionary dictionary;
+  return dictionary;
+}
+
+FacetDictionary& FacetDictionary::devices()
+{
+  static FacetDictionary dictionary;
+  return dictionary;
+}
+
+FacetDictionary& FacetDictionary::families()
+{
+  static FacetDictionary dictionary;
+  return dictionary;
+}
+
+unsigned int FacetDictionary::intern(string_view value)
+{
+  {
+    shared_lock<shared_mutex> lock(d->_lock);
+    unordered_map<string_view, unsigned int>::const_iterator found = d->_ids.find(value);
+    if(found != d->_ids.end())
+      return found->second;
+  }
+
+  unique_lock<shared_mutex> lock(d->_lock);
+  unordered_map<string_view, unsigned int>::const_iterator found = d->_ids.find(value);
+  if(found != d->_ids.end())
+    return found->second;
+
+  unsigned int id = d->_values.size();
+  d->_values.push_back(string(value));
+  d->_ids[d->_values.back()] = id;
+  return id;
+}
+
+int FacetDictionary::find(string_view value) const
+{
+  shared_lock<shared_mutex> lock(d->_lock);
+  unordered_map<string_view, unsigned int>::const_iterator found = d->_ids.find(value);
+  if(found == d->_ids.end())
+    return -1;
+  return found->second;
+}
+
+const string& FacetDictionary::value(unsigned int id) const
+{
+  shared_lock<shared_mutex> lock(d->_lock);
+  return d->_values[id];
+}
+
+unsigned int FacetDictionary::size() const
+{
+  shared_lock<shared_mutex> lock(d->_lock);
+  return d->_values.size();
+}
+
+unsigned int FacetDictionary::rank(unsigned int id) const
+{
+  unique_lock<shared_mutex> lock(d->_lock);
+  d->updateRanks();
+  return d->_ranks[id];
+}
+
+void FacetDictionary::sort(vector<unsigned int>& ids) const
+{
+  vector<unsigned int> ranks;
+  {
+    unique_lock<shared_mutex> lock(d->_lock);
+    d->updateRanks();
+    ranks = d->_ranks;
+  }
+  std::sort(ids.begin(), ids.end(), RankComparator(ranks));
+}
@@ -0,0 +1,39 @@
+#ifndef FACETDICTIONARY_H
+#define FACETDICTIONARY_H
+
+#include <deque>
+#include <vector>
+#include <string>
+#include <string_view>
+
+// Maps each distinct facet value (game type, device, family) to a small
+// integer, so that games and filters only deal with integers. Strings are
+// resolved for display only. Safe to use from several loading threads.
+class FacetDictionary
+{
+  public:
+    FacetDictionary();
+    ~FacetDictionary();
+
+    static FacetDictionary& types();
+    static FacetDictionary& devices();
+    static FacetDictionary& families();
+
+    unsigned int intern(std::string_view value);
+    int find(std::string_view value) const;
+    const std::string& value(unsigned int id) const;
+    unsigned int size() const;
+
+    // Alphabetical rank of an id among all interned values
+    unsigned int rank(unsigned int id) const;
+    void sort(std::vector<unsigned int>& ids) const;
+
+  private:
+    FacetDictionary(const FacetDictionary&);
+    FacetDictionary& operator=(const FacetDictionary&);
+
+    class Private;
+    Private* d;
+};
+
+#endif // FACETDICTIONARY_H
@@ -0,0 +1,394 @@
+#include "FacetIndex.h"
+
+#include <algorithm>
+#include "Collation.h"
+#include "FacetDictionary.h"
+#include "GameTable.h"
+
+using namespace std;
+
+// A value of fewer games than one in SPARSE_RATIO is a list of rows,
+// smaller than a GameSet of the whole catalog
+#define SPARSE_RATIO 32
+
+class FacetIndex::Private
+{
+  public:
+    // Games of a type, device or family value: a GameSet, or their rows
+    // in ascending order when they are few
+    struct Value
+    {
+      GameSet games;
+      vector<unsigned int> rows;
+      bool sparse;
+    };
+
+    Private();
+    ~Private(){}
+
+    unsigned int _size;
+    vector<Value> _types;
+    vector<Value> _devices;
+    // Numbers of players in use, ascending: _players[ii] holds the games
+    // for _playerValues[ii] players or more
+    vector<unsigned int> _playerValues;
+    vector<GameSet> _players;
+    vector<Value> _families;
+    // Normalized text of each value, for queries
+    vector<string> _typeKeys;
+    vector<string> _deviceKeys;
+    vector<string> _familyKeys;
+
+    const vector<Value>* values(Facet facet) const;
+    const vector<string>* keys(Facet facet) const;
+    static void buildLookup(const vector<unsigned int>& values, vector<int>& lookup);
+    static void buildKeys(const FacetDictionary& dictionary, const vector<unsigned int>& values, vector<string>& keys);
+    static void reserve(const vector<unsigned int>& numGames, unsigned int size, vector<Value>& values);
+    static void add(Value& value, unsigned int row);
+
+    static void count(const GameSet& selection, const vector<GameSet>& values, vector<unsigned int>& counts);
+    static void count(const GameSet& selection, const vector<Value>& values, vector<unsigned int>& counts);
+    // result |= games of value
+    static void merge(const Value& value, GameSet& result);
+    static void intersect(const Value& value, GameSet& selection);
+};
+
+FacetIndex::Private::Private():
+  _size(0),
+  _types(),
+  _devices(),
+  _playerValues(),
+  _players(),
+  _families(),
+  _typeKeys(),
+  _deviceKeys(),
+  _familyKeys()
+{}
+
+const vector<FacetIndex::Private::Value>* FacetIndex::Private::values(Facet facet) const
+{
+  switch(facet)
+  {
+    case TYPE: return &_types;
+    case DEVICE: return &_devices;
+    case FAMILY: return &_families;
+    default: return NULL;
+  }
+}
+
+void FacetIndex::Private::buildLookup(const vector<unsigned int>& values, vector<int>& lookup)
+{
+  lookup.clear();
+  for(unsigned int ii = 0; ii < values.size(); ++ii)
+  {
+    if(values[ii] >= lookup.size())
+      lookup.resize(values[ii] + 1, -1);
+    lookup[values[ii]] = ii;
+  }
+}
+
+void FacetIndex::Private::reserve(const vector<unsigned int>& numGames, unsigned int size, vector<Value>& values)
+{
+  values.resize(numGames.size());
+  for(unsigned int ii = 0; ii < numGames.size(); ++ii)
+  {
+    Value& value = values[ii];
+    value.sparse = (unsigned long long) numGames[ii] * SPARSE_RATIO < size;
+    if(value.sparse)
+      value.rows.reserve(numGames[ii]);
+    else
+      value.games.resize(size);
+  }
+}
+
+void FacetIndex::Private::add(Value& value, unsigned int row)
+{
+  if(!value.sparse)
+    value.games.set(row);
+  else if(value.rows.empty() || value.rows.back() != row)
+    value.rows.push_back(row);
+}
+
+void FacetIndex::Private::count(const GameSet& selection, const vector<GameSet>& values, vector<unsigned int>& counts)
+{
+  counts.resize(values.size());
+  for(unsigned int ii = 0; ii < values.size(); ++ii)
+    counts[ii] = selection.countCommon(values[ii]);
+}
+
+void FacetIndex::Private::count(const GameSet& selection, const vector<Value>& values, vector<unsigned int>& counts)
+{
+  counts.resize(values.size());
+  for(unsigned int ii = 0; ii < values.size(); ++ii)
+  {
+    const Value& value = values[ii];
+    if(!value.sparse)
+    {
+      counts[ii] = selection.countCommon(value.games);
+      continue;
+    }
+    counts[ii] = 0;
+    for(unsigned int row = 0; row < value.rows.size(); ++row)
+    {
+      if(selection.test(value.rows[row]))
+        ++counts[ii];
+    }
+  }
+}
+
+void FacetIndex::Private::merge(const Value& value, GameSet& result)
+{
+  if(!value.sparse)
+  {
+    result |= value.games;
+    return;
+  }
+  for(unsigned int row = 0; row < value.rows.size(); ++row)
+    result.set(value.rows[row]);
+}
+
+void FacetIndex::Private::intersect(const Value& value, GameSet& selection)
+{
+  if(!value.sparse)
+  {
+    selection &= value.games;
+    return;
+  }
+  vector<unsigned int> kept;
+  for(unsigned int row = 0; row < value.rows.size(); ++row)
+  {
+    if(selection.test(value.rows[row]))
+      kept.push_back(value.rows[row]);
+  }
+  selection.clear();
+  for(unsigned int row = 0; row < kept.size(); ++row)
+    selection.set(kept[row]);
+}
+
+void FacetIndex::Private::buildKeys(const FacetDictionary& dictionary, const vector<unsigned int>& values, vector<string>& keys)
+{
+  keys.assign(values.size(), string());
+  for(unsigned int ii = 0; ii < values.size(); ++ii)
+    Collation::normalize(dictionary.value(values[ii]), keys[ii]);
+}
+
+const vector<string>* FacetIndex::Private::keys(Facet facet) const
+{
+  switch(facet)
+  {
+    case TYPE: return &_typeKeys;
+    case DEVICE: return &_deviceKeys;
+    case FAMILY: return &_familyKeys;
+    default: return NULL;
+  }
+}
+
+FacetIndex::FacetIndex():
+  d(new Private)
+{}
+
+FacetIndex::~FacetIndex()
+{
+  delete d;
+}
+
+void FacetIndex::clear()
+{
+  d->_size = 0;
+  d->_types.clear();
+  d->_devices.clear();
+  d->_playerValues.clear();
+  d->_players.clear();
+  d->_families.clear();
+  d->_typeKeys.clear();
+  d->_deviceKeys.clear();
+  d->_familyKeys.clear();
+}
+
+void FacetIndex::build(const GameTable& games,
+                       const vector<unsigned int>& types,
+                       const vector<unsigned int>& devices,
+                       const vector<unsigned int>& families)
+{
+  clear();
+
+  d->_size = games.size();
+
+  // FacetDictionary id -> facet value index
+  vector<int> typeLookup, deviceLookup, familyLookup;
+  Private::buildLookup(types, typeLookup);
+  Private::buildLookup(devices, deviceLookup);
+  Private::buildLookup(families, familyLookup);
+
+  // Games are counted first, to size each value
+  vector<unsigned int> typeGames(types.size(), 0);
+  vector<unsigned int> deviceGames(devices.size(), 0);
+  vector<unsigned int> familyGames(families.size(), 0);
+  for(unsigned int ii = 0; ii < games.size(); ++ii)
+  {
+    FacetIds gameTypes = games.types(ii);
+    for(const unsigned int* iter = gameTypes.begin();
+        iter != gameTypes.end();
+        ++iter)
+    {
+      if(*iter < typeLookup.size() && typeLookup[*iter] >= 0)
+        ++typeGames[typeLookup[*iter]];
+    }
+
+    unsigned int device = games.device(ii);
+    if(device < deviceLookup.size() && deviceLookup[device] >= 0)
+      ++deviceGames[deviceLookup[device]];
+
+    FacetIds gameFamilies = games.families(ii);
+    for(const unsigned int* iter = gameFamilies.begin();
+        iter != gameFamilies.end();
+        ++iter)
+    {
+      if(*iter < familyLookup.size() && familyLookup[*iter] >= 0)
+        ++familyGames[familyLookup[*iter]];
+    }
+  } // end for(unsigned int ii = 0; ii < games.size(); ++ii)
+  Private::reserve(typeGames, d->_size, d->_types);
+  Private::reserve(deviceGames, d->_size, d->_devices);
+  Private::reserve(familyGames, d->_size, d->_families);
+
+  Private::buildKeys(FacetDictionary::types(), types, d->_typeKeys);
+  Private::buildKeys(FacetDictionary::devices(), devices, d->_deviceKeys);
+  Private::buildKeys(FacetDictionary::families(), families, d->_familyKeys);
+
+  // One threshold per number of players in use, whatever the numbers
+  for(unsigned int ii = 0; ii < games.size(); ++ii)
+    d->_playerValues.push_back(games.maxPlayers(ii));
+  sort(d->_playerValues.begin(), d->_playerValues.end());
+  d->_playerValues.erase(unique(d->_playerValues.begin(), d->_playerValues.end()), d->_playerValues.end());
+  d->_players.assign(d->_playerValues.size(), GameSet(d->_size));
+
+  for(unsigned int ii = 0; ii < games.size(); ++ii)
+  {
+    FacetIds gameTypes = games.types(ii);
+    for(const unsigned int* iter = gameTypes.begin();
+        iter != gameTypes.end();
+        ++iter)
+    {
+      if(*iter < typeLookup.size() && typeLookup[*iter] >= 0)
+        Private::add(d->_types[typeLookup[*iter]], ii);
+    }
+
+    unsigned int device = games.device(ii);
+    if(device < deviceLookup.size() && deviceLookup[device] >= 0)
+      Private::add(d->_devices[deviceLookup[device]], ii);
+
+    unsigned int numThresholds = upper_bound(d->_playerValues.begin(), d->_playerValues.end(), games.maxPlayers(ii)) - d->_playerValues.begin();
+    for(unsigned int threshold = 0; threshold < numThresholds; ++threshold)
+      d->_players[threshold].set(ii);
+
+    FacetIds gameFamilies = games.families(ii);
+    for(const unsigned int* iter = gameFamilies.begin();
+        iter != gameFamilies.end();
+        ++iter)
+    {
+      if(*iter < familyLookup.size() && familyLookup[*iter] >= 0)
+        Private::add(d->_families[familyLookup[*iter]], ii);
+    }
+  } // end for(unsigned int ii = 0; ii < games.size(); ++ii)
+}
+
+void FacetIndex::select(int type,
+                        int device,
+                        unsigned int minPlayers,
+                        int family,
+                        GameSet& result) const
+{
+  unsigned int threshold = playerThreshold(minPlayers);
+  if(threshold >= d->_players.size())
+  {
+    result.resize(d->_size);
+    return;
+  }
+
+  result = d->_players[threshold];
+
+  if(type >= 0 && type < (int) d->_types.size())
+    Private::intersect(d->_types[type], result);
+
+  if(device >= 0 && device < (int) d->_devices.size())
+    Private::intersect(d->_devices[device], result);
+
+  if(family >= 0 && family < (int) d->_families.size())
+    Private::intersect(d->_families[family], result);
+}
+
+void FacetIndex::intersect(Facet facet, int value, GameSet& selection) const
+{
+  if(value < 0)
+    return;
+
+  if(facet == PLAYERS)
+  {
+    unsigned int threshold = playerThreshold(value);
+    if(threshold < d->_players.size())
+      selection &= d->_players[threshold];
+    else
+      selection.clear();
+    return;
+  }
+
+  const vector<Private::Value>* values = d->values(facet);
+  if(values != NULL && value < (int) values->size())
+    Private::intersect((*values)[value], selection);
+}
+
+void FacetIndex::select(Facet facet, int value, GameSet& result) const
+{
+  if(facet == PLAYERS && value >= 0)
+  {
+    unsigned int threshold = playerThreshold(value);
+    if(threshold < d->_players.size())
+    {
+      result = d->_players[threshold];
+      return;
+    }
+  }
+
+  result.resize(d->_size);
+  const vector<Private::Value>* values = d->values(facet);
+  if(values != NULL && value >= 0 && value < (int) values->size())
+    Private::merge((*values)[value], result);
+}
+
+void FacetIndex::select(Facet facet, string_view normalized, GameSet& result) const
+{
+  result.resize(d->_size);
+  const vector<string>* keys = d->keys(facet);
+  if(keys == NULL)
+    return;
+
+  const vector<Private::Value>& values = *d->values(facet);
+  for(unsigned int ii = 0; ii < keys->size(); ++ii)
+  {
+    if((*keys)[ii] == normalized)
+      Private::merge(values[ii], result);
+  }
+}
+
+void FacetIndex::count(Facet facet, const GameSet& selection, vector<unsigned int>& counts) const
+{
+  switch(facet)
+  {
+    case TYPE: Private::count(selection, d->_types, counts); break;
+    case DEVICE: Private::count(selection, d->_devices, counts); break;
+    case PLAYERS: Private::count(selection, d->_players, counts); break;
+    case FAMILY: Private::count(selection, d->_families, counts); break;
+    default: counts.clear(); break;
+  }
+}
+
+unsigned int FacetIndex::playerThreshold(unsigned int minPlayers) const
+{
+  return lower_bound(d->_playerValues.begin(), d->_playerValues.end(), minPlayers) - d->_playerValues.begin();
+}
+
+unsigned int FacetIndex::size() const
+{
+  return d->_size;
+}
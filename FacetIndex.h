@@ -0,0 +1,71 @@
+#ifndef FACETINDEX_H
+#define FACETINDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "GameSet.h"
+
+class GameTable;
+
+// Games of each facet value (type, device, family) and of each number of
+// players in use, indexed by game position in the sorted catalog. Values of
+// few games keep a list of rows rather than a GameSet.
+class FacetIndex
+{
+  public:
+    enum Facet
+    {
+      TYPE,
+      DEVICE,
+      PLAYERS,
+      FAMILY,
+      NUM_FACETS
+    };
+
+    FacetIndex();
+    ~FacetIndex();
+
+    void clear();
+    // Facet values are FacetDictionary ids
+    void build(const GameTable& games,
+               const std::vector<unsigned int>& types,
+               const std::vector<unsigned int>& devices,
+               const std::vector<unsigned int>& families);
+
+    // type, device and family are indices in the vectors given to build(),
+    // -1 meaning "all".
+    void select(int type,
+                int device,
+                unsigned int minPlayers,
+                int family,
+                GameSet& result) const;
+
+    // selection &= games of the given facet value, -1 meaning "all". For
+    // PLAYERS the value is the minimum number of players.
+    void intersect(Facet facet, int value, GameSet& selection) const;
+
+    // result = games of the given facet value, none if there is no such
+    // value. For PLAYERS the value is the minimum number of players.
+    void select(Facet facet, int value, GameSet& result) const;
+
+    // result = games of the TYPE, DEVICE or FAMILY values whose text
+    // normalized by Collation is the one given, e.g. both "Plate-forme" and
+    // "plate-forme"
+    void select(Facet facet, std::string_view normalized, GameSet& result) const;
+
+    // Number of games of selection for each value of a facet. For PLAYERS,
+    // one count per threshold: see playerThreshold().
+    void count(Facet facet, const GameSet& selection, std::vector<unsigned int>& counts) const;
+    // Threshold of the games for minPlayers players or more, the number of
+    // thresholds if no game is for that many
+    unsigned int playerThreshold(unsigned int minPlayers) const;
+
+    unsigned int size() const;
+
+  private:
+    class Private;
+    Private* d;
+};
+
+#endif // FACETINDEX_H
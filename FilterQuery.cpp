@@ -0,0 +1,409 @@
+#include "FilterQuery.h"
+
+#include <cctype>
+#include <charconv>
+#include "Collation.h"
+#include "Content.h"
+#include "FacetDictionary.h"
+#include "FacetIndex.h"
+#include "GameSet.h"
+#include "NameIndex.h"
+
+using namespace std;
+
+FilterQuery::FilterQuery():
+  _text(),
+  _steps(),
+  _depth(0),
+  _position(0),
+  _message(NULL)
+{}
+
+bool FilterQuery::parse(string_view text, string& message)
+{
+  clear();
+  _text = string(text);
+  _position = 0;
+  _message = &message;
+
+  skipSpaces();
+  bool parsed = parseOr();
+  if(parsed && _position < _text.size())
+  {
+    if(_text[_position] == ')')
+      fail("unexpected ')'");
+    else
+      fail("'and' or 'or' expected");
+    parsed = false;
+  }
+  _message = NULL;
+
+  if(!parsed)
+  {
+    clear();
+    return false;
+  }
+
+  unsigned int depth(0);
+  for(unsigned int ii = 0; ii < _steps.size(); ++ii)
+  {
+    switch(_steps[ii].operation)
+    {
+      case AND:
+      case OR:
+        --depth;
+        break;
+
+      case NOT:
+        break;
+
+      default:
+        if(++depth > _depth)
+          _depth = depth;
+        break;
+    }
+  } // end for(unsigned int ii = 0; ii < _steps.size(); ++ii)
+  return true;
+}
+
+void FilterQuery::clear()
+{
+  _text.clear();
+  _steps.clear();
+  _depth = 0;
+}
+
+bool FilterQuery::empty() const
+{
+  return _steps.empty();
+}
+
+const string& FilterQuery::text() const
+{
+  return _text;
+}
+
+bool FilterQuery::parseOr()
+{
+  if(!parseAnd())
+    return false;
+
+  while(atKeyword("or"))
+  {
+    _position += 2;
+    skipSpaces();
+    if(!parseAnd())
+      return false;
+    Step step = {OR, string(), 0};
+    _steps.push_back(step);
+  }
+  return true;
+}
+
+bool FilterQuery::parseAnd()
+{
+  if(!parseNot())
+    return false;
+
+  while(true)
+  {
+    if(atKeyword("and"))
+    {
+      _position += 3;
+      skipSpaces();
+    }
+    else if(!startsTerm())
+    {
+      return true;
+    }
+
+    if(!parseNot())
+      return false;
+    Step step = {AND, string(), 0};
+    _steps.push_back(step);
+  }
+}
+
+bool FilterQuery::parseNot()
+{
+  if(atKeyword("not"))
+  {
+    _position += 3;
+    skipSpaces();
+    if(!parseNot())
+      return false;
+    Step step = {NOT, string(), 0};
+    _steps.push_back(step);
+    return true;
+  }
+
+  if(_position < _text.size() && _text[_position] == '(')
+  {
+    ++_position;
+    skipSpaces();
+    if(!parseOr())
+      return false;
+    if(_position >= _text.size() || _text[_position] != ')')
+    {
+      fail("')' expected");
+      return false;
+    }
+    ++_position;
+    skipSpaces();
+    return true;
+  }
+
+  return parseTerm();
+}
+
+bool FilterQuery::parseTerm()
+{
+  unsigned int start = _position;
+  string field;
+  while(_position < _text.size() && isalpha((unsigned char) _text[_position]))
+    field += tolower((unsigned char) _text[_position++]);
+  if(field.empty() || _position >= _text.size() || _text[_position] != ':')
+  {
+    _position = start;
+    fail("term expected");
+    return false;
+  }
+
+  Step step = {NAME, string(), 0};
+  if(field == "type")
+    step.operation = TYPE;
+  else if(field == "device")
+    step.operation = DEVICE;
+  else if(field == "players")
+    step.operation = PLAYERS;
+  else if(field == "family")
+    step.operation = FAMILY;
+  else if(field != "name")
+  {
+    _position = start;
+    fail("unknown field '" + field + "'");
+    return false;
+  }
+  ++_position;
+
+  string_view value;
+  if(_position < _text.size() && _text[_position] == '"')
+  {
+    size_t end = _text.find('"', _position + 1);
+    if(end == string::npos)
+    {
+      fail("unterminated text");
+      return false;
+    }
+    value = string_view(_text).substr(_position + 1, end - _position - 1);
+    _position = end + 1;
+  }
+  else
+  {
+    size_t end = _text.find_first_of(" \t\r\n()\"", _position);
+    if(end == string::npos)
+      end = _text.size();
+    value = string_view(_text).substr(_position, end - _position);
+    _position = end;
+  }
+
+  if(value.empty())
+  {
+    fail("value expected");
+    return false;
+  }
+
+  if(step.operation == PLAYERS)
+  {
+    from_chars_result parsed = from_chars(value.data(), value.data() + value.size(), step.players);
+    if(parsed.ec != errc() || parsed.ptr != value.data() + value.size())
+    {
+      _position -= value.size();
+      fail("number of players expected");
+      return false;
+    }
+  }
+  else
+  {
+    Collation::normalize(value, step.value);
+  }
+
+  _steps.push_back(step);
+  skipSpaces();
+  return true;
+}
+
+void FilterQuery::skipSpaces()
+{
+  while(_position < _text.size() && isspace((unsigned char) _text[_position]))
+    ++_position;
+}
+
+bool FilterQuery::atKeyword(string_view keyword) const
+{
+  if(_text.size() - _position < keyword.size())
+    return false;
+  for(unsigned int ii = 0; ii < keyword.size(); ++ii)
+  {
+    if(tolower((unsigned char) _text[_position + ii]) != keyword[ii])
+      return false;
+  }
+  // "order:..." is not "or"
+  unsigned int end = _position + keyword.size();
+  return end == _text.size() || isspace((unsigned char) _text[end]) || string_view("()\"").find(_text[end]) != string_view::npos;
+}
+
+bool FilterQuery::startsTerm() const
+{
+  return _position < _text.size() &&
+         _text[_position] != ')' &&
+         !atKeyword("or");
+}
+
+void FilterQuery::fail(const string& what)
+{
+  if(_message == NULL)
+    return;
+  *_message = what + " at position " + to_string(_position + 1);
+}
+
+void FilterQuery::evaluate(const FacetIndex& index, const NameIndex& names, GameSet& result) const
+{
+  if(_steps.empty())
+  {
+    result.resize(index.size());
+    result.fill();
+    return;
+  }
+
+  // Terms are pushed, operations combine the sets on top word by word
+  vector<GameSet> stack(_depth);
+  unsigned int top(0);
+  for(unsigned int ii = 0; ii < _steps.size(); ++ii)
+  {
+    const Step& step = _steps[ii];
+    switch(step.operation)
+    {
+      case TYPE:
+        index.select(FacetIndex::TYPE, step.value, stack[top++]);
+        break;
+
+      case DEVICE:
+        index.select(FacetIndex::DEVICE, step.value, stack[top++]);
+        break;
+
+      case PLAYERS:
+        index.select(FacetIndex::PLAYERS, step.players, stack[top++]);
+        break;
+
+      case FAMILY:
+        index.select(FacetIndex::FAMILY, step.value, stack[top++]);
+        break;
+
+      case NAME:
+      {
+        // Names starting with the text are a range of the name index
+        GameSet& games = stack[top++];
+        games.resize(index.size());
+        unsigned int first(0);
+        unsigned int last(names.size());
+        names.narrow(step.value, first, last);
+        for(unsigned int entry = first; entry < last; ++entry)
+          games.set(names.row(entry));
+        break;
+      }
+
+      case AND:
+        --top;
+        stack[top - 1] &= stack[top];
+        break;
+
+      case OR:
+        --top;
+        stack[top - 1] |= stack[top];
+        break;
+
+      case NOT:
+        stack[top - 1].flip();
+        break;
+    }
+  } // end for(unsigned int ii = 0; ii < _steps.size(); ++ii)
+
+  std::swap(result, stack[0]);
+}
+
+bool FilterQuery::matches(const Game& game) const
+{
+  if(_steps.empty())
+    return true;
+
+  vector<bool> stack;
+  string normalized;
+  for(unsigned int ii = 0; ii < _steps.size(); ++ii)
+  {
+    const Step& step = _steps[ii];
+    bool match(false);
+    switch(step.operation)
+    {
+      case TYPE:
+      {
+        FacetIds types = game.getGameTypeIds();
+        for(const unsigned int* iter = types.begin(); iter != types.end() && !match; ++iter)
+        {
+          normalized.clear();
+          Collation::normalize(FacetDictionary::types().value(*iter), normalized);
+          match = normalized == step.value;
+        }
+        stack.push_back(match);
+        break;
+      }
+
+      case DEVICE:
+        normalized.clear();
+        Collation::normalize(game.getDevice(), normalized);
+        stack.push_back(normalized == step.value);
+        break;
+
+      case PLAYERS:
+        stack.push_back(game.getMaxPlayers() >= step.players);
+        break;
+
+      case FAMILY:
+      {
+        FacetIds families = game.getGameFamilyIds();
+        for(const unsigned int* iter = families.begin(); iter != families.end() && !match; ++iter)
+        {
+          normalized.clear();
+          Collation::normalize(FacetDictionary::families().value(*iter), normalized);
+          match = normalized == step.value;
+        }
+        stack.push_back(match);
+        break;
+      }
+
+      case NAME:
+        normalized.clear();
+        Collation::normalize(game.getName(), normalized);
+        stack.push_back(normalized.compare(0, step.value.size(), step.value) == 0 ||
+                        Collation::stripArticle(normalized).substr(0, step.value.size()) == step.value);
+        break;
+
+      case AND:
+        match = stack[stack.size() - 2] && stack.back();
+        stack.pop_back();
+        stack.back() = match;
+        break;
+
+      case OR:
+        match = stack[stack.size() - 2] || stack.back();
+        stack.pop_back();
+        stack.back() = match;
+        break;
+
+      case NOT:
+        stack.back() = !stack.back();
+        break;
+    }
+  } // end for(unsigned int ii = 0; ii < _steps.size(); ++ii)
+  return stack.back();
+}
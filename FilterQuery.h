@@ -0,0 +1,85 @@
+#ifndef FILTERQUERY_H
+#define FILTERQUERY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+class FacetIndex;
+class Game;
+class GameSet;
+class NameIndex;
+
+// Boolean filter on the facets and names of the games, such as
+//   type:shmup and not device:"game boy"
+//   type:"beat'em up" players:2 (device:neo-geo or device:arcade)
+// Terms are type:, device:, family:, name: and players: followed by a
+// word or a quoted text. players:N holds the games for N players or more,
+// name: the games whose name starts with the text. Texts are compared as
+// search texts: case, accents and leading article ignored. Terms are
+// combined with not, and, or and parentheses, "and" being implied between
+// two terms.
+//
+// The query is compiled into set operations in postfix order: evaluating
+// it costs a few passes over the bitsets of a FacetIndex.
+class FilterQuery
+{
+  public:
+    FilterQuery();
+
+    // False, with the position of the error in message, if text is not a
+    // query. The query is left empty then.
+    bool parse(std::string_view text, std::string& message);
+    void clear();
+    bool empty() const;
+    const std::string& text() const;
+
+    // result is replaced by the games of the index matching the query
+    void evaluate(const FacetIndex& index, const NameIndex& names, GameSet& result) const;
+
+    // Reference path, game by game
+    bool matches(const Game& game) const;
+
+  private:
+    enum Operation
+    {
+      TYPE,
+      DEVICE,
+      PLAYERS,
+      FAMILY,
+      NAME,
+      AND,
+      OR,
+      NOT
+    };
+
+    struct Step
+    {
+      Operation operation;
+      // Normalized text of a term, number of players for PLAYERS
+      std::string value;
+      unsigned int players;
+    };
+
+    // Recursive descent, from the lowest precedence. Each one appends the
+    // steps of what it read.
+    bool parseOr();
+    bool parseAnd();
+    bool parseNot();
+    bool parseTerm();
+    void skipSpaces();
+    bool atKeyword(std::string_view keyword) const;
+    bool startsTerm() const;
+    void fail(const std::string& what);
+
+    std::string _text;
+    std::vector<Step> _steps;
+    // Sets on the evaluation stack at most
+    unsigned int _depth;
+
+    // Parsing state
+    unsigned int _position;
+    std::string* _message;
+};
+
+#endif // FILTERQUERY_H
@@ -0,0 +1,186 @@
+#include "FuzzyMatcher.h"
+
+#include <algorithm>
+#include "Collation.h"
+#include "GameSet.h"
+#include "GameTable.h"
+
+using namespace std;
+
+// Names matched together
+#define FUZZY_LANES 8
+// Longest pattern, one bit per character
+#define FUZZY_MAX_PATTERN 64
+
+FuzzyMatcher::FuzzyMatcher()
+{
+  clear();
+}
+
+void FuzzyMatcher::clear()
+{
+  _names.clear();
+  _offsets.assign(1, 0);
+  _rows.clear();
+}
+
+void FuzzyMatcher::build(const GameTable& games)
+{
+  clear();
+
+  string name, shortName;
+  for(unsigned int ii = 0; ii < games.size(); ++ii)
+  {
+    name.clear();
+    Collation::normalize(games.name(ii), name);
+    _names.append(name);
+    _offsets.push_back(_names.size());
+    _rows.push_back(ii);
+
+    shortName.clear();
+    Collation::normalize(games.shortName(ii), shortName);
+    if(shortName != name)
+    {
+      _names.append(shortName);
+      _offsets.push_back(_names.size());
+      _rows.push_back(ii);
+    }
+  } // end for(unsigned int ii = 0; ii < games.size(); ++ii)
+}
+
+bool FuzzyMatcher::better(const Match& first, const Match& second)
+{
+  if(first.distance != second.distance)
+    return first.distance < second.distance;
+  if(first.position != second.position)
+    return first.position < second.position;
+  return first.row < second.row;
+}
+
+void FuzzyMatcher::search(string_view text,
+                          unsigned int maxDistance,
+                          const GameSet& selection,
+                          vector<unsigned int>& result) const
+{
+  result.clear();
+
+  string pattern;
+  Collation::normalize(text, pattern);
+  if(pattern.size() > FUZZY_MAX_PATTERN)
+    pattern.resize(FUZZY_MAX_PATTERN);
+  if(pattern.empty())
+    return;
+
+  // Bit ii of peq[c] is set when character ii of the pattern is c
+  uint64_t peq[256] = {0};
+  for(unsigned int ii = 0; ii < pattern.size(); ++ii)
+    peq[(unsigned char) pattern[ii]] |= 1ULL << ii;
+
+  vector<Match> matches;
+  unsigned int batch[FUZZY_LANES], distances[FUZZY_LANES], positions[FUZZY_LANES];
+  unsigned int count(0);
+  for(unsigned int name = 0; name <= _rows.size(); ++name)
+  {
+    // Names of selected games are matched by full batches, then the rest
+    if(name < _rows.size())
+    {
+      if(!selection.test(_rows[name]))
+        continue;
+      batch[count++] = name;
+      if(count < FUZZY_LANES)
+        continue;
+    }
+    if(count == 0)
+      continue;
+
+    matchBatch(peq, pattern.size(), batch, count, distances, positions);
+    for(unsigned int lane = 0; lane < count; ++lane)
+    {
+      if(distances[lane] <= maxDistance)
+      {
+        Match match = {distances[lane], positions[lane], _rows[batch[lane]]};
+        matches.push_back(match);
+      }
+    }
+    count = 0;
+  } // end for(unsigned int name = 0; name <= _rows.size(); ++name)
+
+  std::sort(matches.begin(), matches.end(), better);
+
+  // A game found by name and short name is ranked by the best of both
+  GameSet found(selection.size());
+  for(vector<Match>::const_iterator iter = matches.begin();
+      iter != matches.end();
+      ++iter)
+  {
+    if(!found.test(iter->row))
+    {
+      found.set(iter->row);
+      result.push_back(iter->row);
+    }
+  }
+}
+
+void FuzzyMatcher::matchBatch(const uint64_t* peq,
+                              unsigned int length,
+                              const unsigned int* names,
+                              unsigned int count,
+                              unsigned int* distances,
+                              unsigned int* positions) const
+{
+  const char* text[FUZZY_LANES];
+  unsigned int size[FUZZY_LANES];
+  uint64_t pv[FUZZY_LANES], mv[FUZZY_LANES];
+  unsigned int score[FUZZY_LANES];
+  unsigned int longest(0);
+
+  for(unsigned int lane = 0; lane < FUZZY_LANES; ++lane)
+  {
+    text[lane] = _names.data();
+    size[lane] = 0;
+    if(lane < count)
+    {
+      text[lane] += _offsets[names[lane]];
+      size[lane] = _offsets[names[lane] + 1] - _offsets[names[lane]];
+    }
+    if(size[lane] > longest)
+      longest = size[lane];
+
+    pv[lane] = ~0ULL;
+    mv[lane] = 0;
+    score[lane] = length;
+    distances[lane] = length;
+    positions[lane] = 0;
+  }
+
+  // Myers' algorithm, searching the pattern anywhere in the names: the
+  // vertical deltas of the edit distance matrix are kept as bit vectors,
+  // score is the distance for the pattern ending at the current character.
+  // Lanes past the end of their name read '\0', which the pattern never
+  // contains, and are not recorded.
+  unsigned int last = length - 1;
+  for(unsigned int position = 0; position < longest; ++position)
+  {
+    for(unsigned int lane = 0; lane < FUZZY_LANES; ++lane)
+    {
+      bool active = position < size[lane];
+      unsigned char character = active ? text[lane][position] : 0;
+
+      uint64_t eq = peq[character];
+      uint64_t xv = eq | mv[lane];
+      uint64_t xh = (((eq & pv[lane]) + pv[lane]) ^ pv[lane]) | eq;
+      uint64_t ph = mv[lane] | ~(xh | pv[lane]);
+      uint64_t mh = pv[lane] & xh;
+      score[lane] += (unsigned int) ((ph >> last) & 1);
+      score[lane] -= (unsigned int) ((mh >> last) & 1);
+      ph <<= 1;
+      mh <<= 1;
+      pv[lane] = mh | ~(xv | ph);
+      mv[lane] = ph & xv;
+
+      bool improves = active && score[lane] < distances[lane];
+      distances[lane] = improves ? score[lane] : distances[lane];
+      positions[lane] = improves ? position : positions[lane];
+    }
+  } // end for(unsigned int position = 0; position < longest; ++position)
+}
@@ -0,0 +1,56 @@
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+
+class GameSet;
+class GameTable;
+
+// Typo tolerant search in the names and short names of the games, as
+// normalized by Collation. Each name is matched with Myers' bit-parallel
+// edit distance, several names at a time so that the compiler can use
+// vector instructions.
+class FuzzyMatcher
+{
+  public:
+    FuzzyMatcher();
+
+    void clear();
+    void build(const GameTable& games);
+
+    // Rows of selection whose name or short name contains text with at most
+    // maxDistance edits, best first: fewest edits, then earliest match,
+    // then catalog order. Only the first 64 characters of text are used.
+    void search(std::string_view text,
+                unsigned int maxDistance,
+                const GameSet& selection,
+                std::vector<unsigned int>& result) const;
+
+  private:
+    struct Match
+    {
+      unsigned int distance;
+      unsigned int position;
+      unsigned int row;
+    };
+
+    static bool better(const Match& first, const Match& second);
+
+    // Best matches of the pattern in a batch of names
+    void matchBatch(const uint64_t* peq,
+                    unsigned int length,
+                    const unsigned int* names,
+                    unsigned int count,
+                    unsigned int* distances,
+                    unsigned int* positions) const;
+
+    std::string _names;
+    // Name ii is _names[_offsets[ii]] to _names[_offsets[ii+1]], of row _rows[ii]
+    std::vector<uint32_t> _offsets;
+    std::vector<unsigned int> _rows;
+};
+
+#endif // FUZZYMATCHER_H
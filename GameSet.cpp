@@ -0,0 +1,115 @@
+#include "GameSet.h"
+
+using namespace std;
+
+#define WORD_BITS 64
+
+GameSet::GameSet():
+  _words(),
+  _size(0)
+{}
+
+GameSet::GameSet(unsigned int size):
+  _words(),
+  _size(0)
+{
+  resize(size);
+}
+
+void GameSet::resize(unsigned int size)
+{
+  _size = size;
+  _words.assign((size + WORD_BITS - 1) / WORD_BITS, 0);
+}
+
+unsigned int GameSet::size() const
+{
+  return _size;
+}
+
+void GameSet::set(unsigned int index)
+{
+  _words[index / WORD_BITS] |= (uint64_t(1) << (index % WORD_BITS));
+}
+
+void GameSet::reset(unsigned int index)
+{
+  _words[index / WORD_BITS] &= ~(uint64_t(1) << (index % WORD_BITS));
+}
+
+bool GameSet::test(unsigned int index) const
+{
+  return (_words[index / WORD_BITS] >> (index % WORD_BITS)) & 1;
+}
+
+void GameSet::fill()
+{
+  for(unsigned int ii = 0; ii < _words.size(); ++ii)
+    _words[ii] = ~uint64_t(0);
+  clearPadding();
+}
+
+void GameSet::clear()
+{
+  for(unsigned int ii = 0; ii < _words.size(); ++ii)
+    _words[ii] = 0;
+}
+
+void GameSet::flip()
+{
+  for(unsigned int ii = 0; ii < _words.size(); ++ii)
+    _words[ii] = ~_words[ii];
+  clearPadding();
+}
+
+GameSet& GameSet::operator&=(const GameSet& other)
+{
+  // Plain word loops: the compiler vectorizes them
+  const unsigned int numWords = _words.size();
+  for(unsigned int ii = 0; ii < numWords; ++ii)
+    _words[ii] &= other._words[ii];
+  return *this;
+}
+
+GameSet& GameSet::operator|=(const GameSet& other)
+{
+  const unsigned int numWords = _words.size();
+  for(unsigned int ii = 0; ii < numWords; ++ii)
+    _words[ii] |= other._words[ii];
+  return *this;
+}
+
+unsigned int GameSet::count() const
+{
+  unsigned int res(0);
+  for(unsigned int ii = 0; ii < _words.size(); ++ii)
+    res += __builtin_popcountll(_words[ii]);
+  return res;
+}
+
+unsigned int GameSet::countCommon(const GameSet& other) const
+{
+  unsigned int res(0);
+  for(unsigned int ii = 0; ii < _words.size() && ii < other._words.size(); ++ii)
+    res += __builtin_popcountll(_words[ii] & other._words[ii]);
+  return res;
+}
+
+void GameSet::indices(vector<unsigned int>& result) const
+{
+  for(unsigned int ii = 0; ii < _words.size(); ++ii)
+  {
+    uint64_t word = _words[ii];
+    while(word != 0)
+    {
+      result.push_back(ii * WORD_BITS + __builtin_ctzll(word));
+      word &= word - 1;
+    }
+  }
+}
+
+void GameSet::clearPadding()
+{
+  if(_size % WORD_BITS != 0)
+    _words.back() &= (uint64_t(1) << (_size % WORD_BITS)) - 1;
+}
@@ -0,0 +1,42 @@
+#ifndef GAMESET_H
+#define GAMESET_H
+
+#include <vector>
+#include <stdint.h>
+
+// Fixed-size set of game indices, stored as a bitset so that filters can be
+// combined word by word.
+class GameSet
+{
+  public:
+    GameSet();
+    explicit GameSet(unsigned int size);
+
+    void resize(unsigned int size);
+    unsigned int size() const;
+
+    void set(unsigned int index);
+    void reset(unsigned int index);
+    bool test(unsigned int index) const;
+
+    void fill();
+    void clear();
+    // Complement
+    void flip();
+
+    GameSet& operator&=(const GameSet& other);
+    GameSet& operator|=(const GameSet& other);
+
+    unsigned int count() const;
+    // Size of the intersection, without building it
+    unsigned int countCommon(const GameSet& other) const;
+    void indices(std::vector<unsigned int>& result) const;
+
+  private:
+    void clearPadding();
+
+    std::vector<uint64_t> _words;
+    unsigned int _size;
+};
+
+#endif // GAMESET_H
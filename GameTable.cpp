@@ -0,0 +1,376 @@
+#include "GameTable.h"
+
+#include <cstring>
+#include "defines.h"
+
+using namespace std;
+
+namespace
+{
+  template<typename T>
+  void saveColumn(const vector<T>& column, string& buffer)
+  {
+    uint32_t count = column.size();
+    buffer.append(reinterpret_cast<const char*>(&count), sizeof(count));
+    if(count > 0)
+      buffer.append(reinterpret_cast<const char*>(column.data()), count * sizeof(T));
+  }
+
+  template<typename T>
+  bool loadColumn(const char*& data, const char* end, vector<T>& column)
+  {
+    uint32_t count;
+    if((size_t) (end - data) < sizeof(count))
+      return false;
+    memcpy(&count, data, sizeof(count));
+    data += sizeof(count);
+    if(count > (size_t) (end - data) / sizeof(T))
+      return false;
+    column.resize(count);
+    if(count > 0)
+      memcpy(column.data(), data, count * sizeof(T));
+    data += count * sizeof(T);
+    return true;
+  }
+
+  bool loadStrings(const char*& data, const char* end, StringArena& strings)
+  {
+    uint32_t size;
+    if((size_t) (end - data) < sizeof(size))
+      return false;
+    memcpy(&size, data, sizeof(size));
+    data += sizeof(size);
+    if(size > (size_t) (end - data))
+      return false;
+    strings.assign(string_view(data, size));
+    data += size;
+    return true;
+  }
+
+  template<typename T>
+  void reorderColumn(vector<T>& column, const vector<unsigned int>& order)
+  {
+    vector<T> reordered;
+    reordered.reserve(order.size());
+    for(unsigned int ii = 0; ii < order.size(); ++ii)
+      reordered.push_back(column[order[ii]]);
+    column.swap(reordered);
+  }
+
+  void reorderIds(vector<unsigned int>& offsets, vector<unsigned int>& ids, const vector<unsigned int>& order)
+  {
+    vector<unsigned int> reorderedOffsets, reorderedIds;
+    reorderedOffsets.reserve(offsets.size());
+    reorderedIds.reserve(ids.size());
+    reorderedOffsets.push_back(0);
+    for(unsigned int ii = 0; ii < order.size(); ++ii)
+    {
+      reorderedIds.insert(reorderedIds.end(), ids.begin() + offsets[order[ii]], ids.begin() + offsets[order[ii] + 1]);
+      reorderedOffsets.push_back(reorderedIds.size());
+    }
+    offsets.swap(reorderedOffsets);
+    ids.swap(reorderedIds);
+  }
+
+  bool remapIds(vector<unsigned int>& ids, const vector<unsigned int>& map)
+  {
+    for(unsigned int ii = 0; ii < ids.size(); ++ii)
+    {
+      if(ids[ii] >= map.size())
+        return false;
+      ids[ii] = map[ids[ii]];
+    }
+    return true;
+  }
+
+  bool checkOffsets(const vector<unsigned int>& offsets, unsigned int numGames, unsigned int numIds)
+  {
+    if(offsets.size() != numGames + 1 || offsets[0] != 0 || offsets[numGames] != numIds)
+      return false;
+    for(unsigned int ii = 0; ii < numGames; ++ii)
+    {
+      if(offsets[ii] > offsets[ii + 1])
+        return false;
+    }
+    return true;
+  }
+}
+
+bool FacetIds::contains(unsigned int id) const
+{
+  for(const unsigned int* iter = _first; iter != _last; ++iter)
+  {
+    if(*iter == id)
+      return true;
+  }
+  return false;
+}
+
+GameTable::GameTable()
+{
+  clear();
+}
+
+void GameTable::clear()
+{
+  _names.clear();
+  _shortNames.clear();
+  _sortKeys.clear();
+  _picturePaths.clear();
+  _commandLines.clear();
+  _devices.clear();
+  _maxPlayers.clear();
+  _typeOffsets.assign(1, 0);
+  _types.clear();
+  _familyOffsets.assign(1, 0);
+  _families.clear();
+  _strings.clear();
+  _positions = NULL;
+}
+
+void GameTable::reserve(unsigned int numGames)
+{
+  _names.reserve(numGames);
+  _shortNames.reserve(numGames);
+  _sortKeys.reserve(numGames);
+  _picturePaths.reserve(numGames);
+  _commandLines.reserve(numGames);
+  _devices.reserve(numGames);
+  _maxPlayers.reserve(numGames);
+  _typeOffsets.reserve(numGames + 1);
+  _familyOffsets.reserve(numGames + 1);
+}
+
+unsigned int GameTable::size() const
+{
+  return _names.size();
+}
+
+unsigned int GameTable::addGame(string_view name,
+                                string_view shortName,
+                                string_view sortKey,
+                                const vector<unsigned int>& types,
+                                unsigned int device,
+                                unsigned int maxPlayers,
+                                const vector<unsigned int>& families,
+                                string_view picturePath,
+                                string_view commandLine)
+{
+  _names.push_back(_strings.intern(name));
+  _shortNames.push_back(shortName.empty() ? _names.back() : _strings.intern(shortName.substr(0, MAX_SHORTNAME_LENGTH)));
+  _sortKeys.push_back(sortKey.empty() ? _names.back() : _strings.intern(sortKey));
+  _picturePaths.push_back(_strings.intern(picturePath));
+  _commandLines.push_back(_strings.intern(commandLine));
+  _devices.push_back(device);
+  _maxPlayers.push_back(maxPlayers);
+  _types.insert(_types.end(), types.begin(), types.end());
+  _typeOffsets.push_back(_types.size());
+  _families.insert(_families.end(), families.begin(), families.end());
+  _familyOffsets.push_back(_families.size());
+  return _names.size() - 1;
+}
+
+unsigned int GameTable::addGame(const GameTable& other, unsigned int row)
+{
+  _names.push_back(_strings.intern(other.name(row)));
+  _shortNames.push_back(_strings.intern(other.shortName(row)));
+  _sortKeys.push_back(_strings.intern(other.sortKey(row)));
+  _picturePaths.push_back(_strings.intern(other.picturePath(row)));
+  _commandLines.push_back(_strings.intern(other.commandLine(row)));
+  _devices.push_back(other._devices[row]);
+  _maxPlayers.push_back(other._maxPlayers[row]);
+  FacetIds gameTypes = other.types(row);
+  _types.insert(_types.end(), gameTypes.begin(), gameTypes.end());
+  _typeOffsets.push_back(_types.size());
+  FacetIds gameFamilies = other.families(row);
+  _families.insert(_families.end(), gameFamilies.begin(), gameFamilies.end());
+  _familyOffsets.push_back(_families.size());
+  return _names.size() - 1;
+}
+
+void GameTable::append(const GameTable& other)
+{
+  unsigned int typeOffset = _types.size();
+  unsigned int familyOffset = _families.size();
+
+  for(unsigned int ii = 0; ii < other.size(); ++ii)
+  {
+    // Interned again: strings are shared across tables
+    _names.push_back(_strings.intern(other.name(ii)));
+    _shortNames.push_back(_strings.intern(other.shortName(ii)));
+    _sortKeys.push_back(_strings.intern(other.sortKey(ii)));
+    _picturePaths.push_back(_strings.intern(other.picturePath(ii)));
+    _commandLines.push_back(_strings.intern(other.commandLine(ii)));
+    _typeOffsets.push_back(other._typeOffsets[ii + 1] + typeOffset);
+    _familyOffsets.push_back(other._familyOffsets[ii + 1] + familyOffset);
+  }
+
+  _devices.insert(_devices.end(), other._devices.begin(), other._devices.end());
+  _maxPlayers.insert(_maxPlayers.end(), other._maxPlayers.begin(), other._maxPlayers.end());
+  _types.insert(_types.end(), other._types.begin(), other._types.end());
+  _families.insert(_families.end(), other._families.begin(), other._families.end());
+}
+
+void GameTable::shrink()
+{
+  _names.shrink_to_fit();
+  _shortNames.shrink_to_fit();
+  _sortKeys.shrink_to_fit();
+  _picturePaths.shrink_to_fit();
+  _commandLines.shrink_to_fit();
+  _devices.shrink_to_fit();
+  _maxPlayers.shrink_to_fit();
+  _typeOffsets.shrink_to_fit();
+  _types.shrink_to_fit();
+  _familyOffsets.shrink_to_fit();
+  _families.shrink_to_fit();
+  _strings.shrink();
+}
+
+void GameTable::reorder(const vector<unsigned int>& order)
+{
+  // Text stays in place in the arena, only its references move
+  reorderColumn(_names, order);
+  reorderColumn(_shortNames, order);
+  reorderColumn(_sortKeys, order);
+  reorderColumn(_picturePaths, order);
+  reorderColumn(_commandLines, order);
+  reorderColumn(_devices, order);
+  reorderColumn(_maxPlayers, order);
+  reorderIds(_typeOffsets, _types, order);
+  reorderIds(_familyOffsets, _families, order);
+}
+
+bool GameTable::remapFacets(const vector<unsigned int>& typeMap,
+                            const vector<unsigned int>& deviceMap,
+                            const vector<unsigned int>& familyMap)
+{
+  return remapIds(_types, typeMap) &&
+         remapIds(_devices, deviceMap) &&
+         remapIds(_families, familyMap);
+}
+
+string_view GameTable::name(unsigned int row) const
+{
+  return _strings.view(_names[row]);
+}
+
+string_view GameTable::shortName(unsigned int row) const
+{
+  return _strings.view(_shortNames[row]);
+}
+
+string_view GameTable::sortKey(unsigned int row) const
+{
+  return _strings.view(_sortKeys[row]);
+}
+
+string_view GameTable::picturePath(unsigned int row) const
+{
+  return _strings.view(_picturePaths[row]);
+}
+
+string_view GameTable::commandLine(unsigned int row) const
+{
+  return _strings.view(_commandLines[row]);
+}
+
+unsigned int GameTable::device(unsigned int row) const
+{
+  return _devices[row];
+}
+
+unsigned int GameTable::maxPlayers(unsigned int row) const
+{
+  return _maxPlayers[row];
+}
+
+void GameTable::setPositions(const unsigned int* positions)
+{
+  _positions = positions;
+}
+
+unsigned int GameTable::position(unsigned int row) const
+{
+  return _positions != NULL ? _positions[row] : row;
+}
+
+FacetIds GameTable::types(unsigned int row) const
+{
+  return FacetIds(_types.data() + _typeOffsets[row], _types.data() + _typeOffsets[row + 1]);
+}
+
+FacetIds GameTable::families(unsigned int row) const
+{
+  return FacetIds(_families.data() + _familyOffsets[row], _families.data() + _familyOffsets[row + 1]);
+}
+
+void GameTable::save(string& buffer) const
+{
+  saveColumn(_names, buffer);
+  saveColumn(_shortNames, buffer);
+  saveColumn(_sortKeys, buffer);
+  saveColumn(_picturePaths, buffer);
+  saveColumn(_commandLines, buffer);
+  saveColumn(_devices, buffer);
+  saveColumn(_maxPlayers, buffer);
+  saveColumn(_typeOffsets, buffer);
+  saveColumn(_types, buffer);
+  saveColumn(_familyOffsets, buffer);
+  saveColumn(_families, buffer);
+
+  const string& strings = _strings.buffer();
+  uint32_t stringsSize = strings.size();
+  buffer.append(reinterpret_cast<const char*>(&stringsSize), sizeof(stringsSize));
+  buffer.append(strings);
+}
+
+bool GameTable::load(const char* data, size_t size)
+{
+  const char* end = data + size;
+  bool valid = loadColumn(data, end, _names) &&
+               loadColumn(data, end, _shortNames) &&
+               loadColumn(data, end, _sortKeys) &&
+               loadColumn(data, end, _picturePaths) &&
+               loadColumn(data, end, _commandLines) &&
+               loadColumn(data, end, _devices) &&
+               loadColumn(data, end, _maxPlayers) &&
+               loadColumn(data, end, _typeOffsets) &&
+               loadColumn(data, end, _types) &&
+               loadColumn(data, end, _familyOffsets) &&
+               loadColumn(data, end, _families) &&
+               loadStrings(data, end, _strings) &&
+               data == end;
+
+  unsigned int numGames = _names.size();
+  valid = valid &&
+          _shortNames.size() == numGames &&
+          _sortKeys.size() == numGames &&
+          _picturePaths.size() == numGames &&
+          _commandLines.size() == numGames &&
+          _devices.size() == numGames &&
+          _maxPlayers.size() == numGames &&
+          checkOffsets(_typeOffsets, numGames, _types.size()) &&
+          checkOffsets(_familyOffsets, numGames, _families.size());
+
+  if(valid)
+  {
+    // Every text must be in the arena and followed by its '\0'
+    const string& strings = _strings.buffer();
+    const vector<Text>* columns[] = {&_names, &_shortNames, &_sortKeys, &_picturePaths, &_commandLines};
+    for(unsigned int column = 0; valid && column < 5; ++column)
+    {
+      for(unsigned int ii = 0; valid && ii < numGames; ++ii)
+      {
+        Text text = (*columns[column])[ii];
+        valid = text.offset < strings.size() &&
+                text.length < strings.size() - text.offset &&
+                strings[text.offset + text.length] == '\0';
+      }
+    }
+  }
+
+  if(!valid)
+    clear();
+  return valid;
+}
@@ -0,0 +1,106 @@
+#ifndef GAMETABLE_H
+#define GAMETABLE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+#include "StringArena.h"
+
+// Ids of the types or families of one game
+class FacetIds
+{
+  public:
+    FacetIds(const unsigned int* first, const unsigned int* last): _first(first), _last(last) {}
+
+    const unsigned int* begin() const {return _first;}
+    const unsigned int* end() const {return _last;}
+    unsigned int size() const {return _last - _first;}
+    bool empty() const {return _first == _last;}
+    unsigned int operator[](unsigned int index) const {return _first[index];}
+    bool contains(unsigned int id) const;
+
+  private:
+    const unsigned int* _first;
+    const unsigned int* _last;
+};
+
+// The games of the catalog, stored by column: one array per field, the
+// type and family ids of all games in one array each, and all text in a
+// StringArena. Games are rows, designated by their index.
+// Facet values are FacetDictionary ids. Text is returned as views into the
+// arena, each followed by a '\0' so that data() can be given to C functions.
+class GameTable
+{
+  public:
+    GameTable();
+
+    void clear();
+    void reserve(unsigned int numGames);
+    unsigned int size() const;
+
+    // Empty short name and sort key default to the name. Returns the row.
+    unsigned int addGame(std::string_view name,
+                         std::string_view shortName,
+                         std::string_view sortKey,
+                         const std::vector<unsigned int>& types,
+                         unsigned int device,
+                         unsigned int maxPlayers,
+                         const std::vector<unsigned int>& families,
+                         std::string_view picturePath,
+                         std::string_view commandLine);
+    unsigned int addGame(const GameTable& other, unsigned int row);
+    void append(const GameTable& other);
+
+    // Releases what was only needed while adding games
+    void shrink();
+
+    // Row ii becomes former row order[ii]
+    void reorder(const std::vector<unsigned int>& order);
+
+    // Positions of the rows in another order, kept by the caller, or NULL
+    // for rows in their own order
+    void setPositions(const unsigned int* positions);
+    unsigned int position(unsigned int row) const;
+
+    // Facet ids are replaced by map[id]. False if an id is not in its map,
+    // the table is then left partly remapped.
+    bool remapFacets(const std::vector<unsigned int>& typeMap,
+                     const std::vector<unsigned int>& deviceMap,
+                     const std::vector<unsigned int>& familyMap);
+
+    std::string_view name(unsigned int row) const;
+    std::string_view shortName(unsigned int row) const;
+    std::string_view sortKey(unsigned int row) const;
+    std::string_view picturePath(unsigned int row) const;
+    std::string_view commandLine(unsigned int row) const;
+    unsigned int device(unsigned int row) const;
+    unsigned int maxPlayers(unsigned int row) const;
+    FacetIds types(unsigned int row) const;
+    FacetIds families(unsigned int row) const;
+
+    // Raw image of the columns, for CatalogCache. load() checks that the
+    // image is consistent and leaves the table empty if it is not.
+    void save(std::string& buffer) const;
+    bool load(const char* data, size_t size);
+
+  private:
+    typedef StringArena::Ref Text;
+
+    std::vector<Text> _names;
+    std::vector<Text> _shortNames;
+    std::vector<Text> _sortKeys;
+    std::vector<Text> _picturePaths;
+    std::vector<Text> _commandLines;
+    std::vector<unsigned int> _devices;
+    std::vector<unsigned int> _maxPlayers;
+    // The types of row ii are _types[_typeOffsets[ii]] to _types[_typeOffsets[ii+1]]
+    std::vector<unsigned int> _typeOffsets;
+    std::vector<unsigned int> _types;
+    std::vector<unsigned int> _familyOffsets;
+    std::vector<unsigned int> _families;
+    StringArena _strings;
+    const unsigned int* _positions;
+};
+
+#endif // GAMETABLE_H
@@ -1,5 +1,8 @@
 #include "GraphicElements.h"
+#include "CommandQueue.h"
 #include "Content.h"
+#include "FacetDictionary.h"
+#include "Selection.h"
 #include <iostream>
 #include "SDL_image.h"
 #include "SDL_mixer.h"
@@ -259,6 +262,21 @@ class GraphicElements::Private
     string _currentCommand;
     string _currentSystem;
 
+    // Filter labels, in screen order. Only the last filter changed shows
+    // its number of games.
+    enum {FILTER_DEVICE, FILTER_TYPE, FILTER_MULTI, FILTER_FAMILY, NUM_FILTERS};
+    string _filterValues[NUM_FILTERS];
+    int _countedFilter;
+
+    // The search text and the collection share the line above the games
+    bool _searching;
+    string _collectionLabel;
+
+    void drawFilter(unsigned int filter, const string& value, int count);
+    void showFilter(unsigned int filter, const string& value, int count);
+    void drawTitle(const string& label);
+    void showCollection(const string& collection, int count);
+
 #ifndef BEFORE_MODIF
     void scheduleArtwork(const string& art);
 #endif
@@ -278,7 +296,10 @@ GraphicElements::Private::Private():
   _screen(NULL),
   _frame(0),
   _bling(NULL),
-  _bump(NULL)
+  _bump(NULL),
+  _countedFilter(-1),
+  _searching(false),
+  _collectionLabel()
 {
   _elements._fonts._titlesFont = NULL;
   _elements._fonts._entriesFont = NULL;
@@ -308,6 +329,62 @@ GraphicElements::Private::~Private()
   reset();
 }
 
+void GraphicElements::Private::drawFilter(unsigned int filter, const string& value, int count)
+{
+  static const char* const defaults[NUM_FILTERS] = {TEXT_ALL, TEXT_ALL, "1P/2P/3P", TEXT_ALL};
+  SurfaceRect* labels[NUM_FILTERS] = {&_elements._deviceElements._deviceName,
+                                      &_elements._typeElements._typeName,
+                                      &_elements._multiElements._multiName,
+                                      &_elements._familyElements._familyName};
+
+  _filterValues[filter] = value;
+  string label = value.empty() ? defaults[filter] : value;
+  if(count >= 0)
+    label += " (" + to_string(count) + ")";
+  labels[filter]->setText(label.c_str(), _elements._fonts._entriesFont,
+                          _elements._fonts._entriesColor2,
+                          false,
+                          _parameters._filterXOffset + 150, _parameters._filterYOffset + filter * _parameters._filterYPadding);
+}
+
+void GraphicElements::Private::showFilter(unsigned int filter, const string& value, int count)
+{
+  // The count of the previous filter is out of date
+  if(_countedFilter >= 0 && _countedFilter != (int) filter)
+    drawFilter(_countedFilter, _filterValues[_countedFilter], -1);
+
+  drawFilter(filter, value, count);
+  _countedFilter = (count >= 0) ? filter : -1;
+}
+
+void GraphicElements::Private::drawTitle(const string& label)
+{
+  if(label.empty())
+  {
+    _elements._gamesElements._title.clear();
+    return;
+  }
+
+  _elements._gamesElements._title.setText(label.c_str(), _elements._fonts._entriesFont,
+                                          _elements._fonts._titleColor,
+                                          false,
+                                          _parameters._gameLineXOffset, _parameters._gameLineYOffset - 2 * _parameters._gameLineYPadding);
+}
+
+void GraphicElements::Private::showCollection(const string& collection, int count)
+{
+  _collectionLabel.clear();
+  if(!collection.empty())
+  {
+    _collectionLabel = string(TEXT_COLLECTION) + " : " + collection;
+    if(count >= 0)
+      _collectionLabel += " (" + to_string(count) + ")";
+  }
+
+  if(!_searching)
+    drawTitle(_collectionLabel);
+}
+
 void GraphicElements::Private::reset()
 {
   _frame = 0;
@@ -747,7 +824,7 @@ void GraphicElements::setCurrentFrame(unsigned int frame)
   d->_frame = frame;
 }
 
-void GraphicElements::setVisibleGames(const std::vector<Game*> &games, unsigned int cursorPosition)
+void GraphicElements::setVisibleGames(const Selection& games, unsigned int cursorPosition)
 {
   hideKeyLayout();
 
@@ -755,7 +832,7 @@ void GraphicElements::setVisibleGames(const std::vector<Game*> &games, unsigned
   {
     if(ii < games.size())
     {
-      d->_elements._gamesElements._gameTitles[ii]->setText(games[ii]->getShortName().c_str(), d->_elements._fonts._entriesFont, d->_elements._fonts._entriesColor, false, d->_parameters._gameLineXOffset, d->_parameters._gameLineYOffset + ii*d->_parameters._gameLineYPadding);
+      d->_elements._gamesElements._gameTitles[ii]->setText(games.game(ii).getShortName().data(), d->_elements._fonts._entriesFont, d->_elements._fonts._entriesColor, false, d->_parameters._gameLineXOffset, d->_parameters._gameLineYOffset + ii*d->_parameters._gameLineYPadding);
     }
     else
     {
@@ -770,33 +847,33 @@ void GraphicElements::setVisibleGames(const std::vector<Game*> &games, unsigned
   d->_elements._mainElements._artwork.clear();
   if(cursorPosition < games.size())
   {
-    Game* game = games[cursorPosition];
-    d->_elements._mainElements._gameName.setText(game->getName().c_str(), d->_elements._fonts._entriesFont, d->_elements._fonts._entriesColor2, true, 800, 80);
-    d->_elements._mainElements._deviceName.setText(game->getDevice().c_str(), d->_elements._fonts._entriesFont, d->_elements._fonts._entriesColor2, false, 550, 150);
+    Game game = games.game(cursorPosition);
+    d->_elements._mainElements._gameName.setText(game.getName().data(), d->_elements._fonts._entriesFont, d->_elements._fonts._entriesColor2, true, 800, 80);
+    d->_elements._mainElements._deviceName.setText(game.getDevice().c_str(), d->_elements._fonts._entriesFont, d->_elements._fonts._entriesColor2, false, 550, 150);
     string type;
-    const list<string>& types = game->getGameTypes();
-    for(list<string>::const_iterator iter = types.begin();
+    FacetIds types = game.getGameTypeIds();
+    for(const unsigned int* iter = types.begin();
         iter != types.end();
         ++iter)
     {
       if(iter != types.begin())
         type.append(", ");
-      type.append(*iter);
+      type.append(FacetDictionary::types().value(*iter));
     }
     if(type.empty())
       type = "-";
     d->_elements._mainElements._typeName.setText(type.c_str(), d->_elements._fonts._entriesFont, d->_elements._fonts._entriesColor2, false, 500, 200);
-    d->_elements._mainElements._multiName.setText(game->getMaxPlayersString().c_str(), d->_elements._fonts._entriesFont, d->_elements._fonts._entriesColor2, false, 650, 250);
-    if(!game->getPicturePath().empty())
+    d->_elements._mainElements._multiName.setText(game.getMaxPlayersString().c_str(), d->_elements._fonts._entriesFont, d->_elements._fonts._entriesColor2, false, 650, 250);
+    if(!game.getPicturePath().empty())
     {
 #ifdef BEFORE_MODIF
-      d->_elements._mainElements._artwork.setImage(game->getPicturePath().c_str(), 1050, 250, true, d->_screen);
+      d->_elements._mainElements._artwork.setImage(game.getPicturePath().data(), 1050, 250, true, d->_screen);
 #else
-      d->scheduleArtwork(game->getPicturePath());
+      d->scheduleArtwork(string(game.getPicturePath()));
 #endif
     }
-    d->_currentCommand = game->getCommandLine();
-    d->_currentSystem = game->getDevice();
+    d->_currentCommand = game.getCommandLine();
+    d->_currentSystem = game.getDevice();
   }
   else
   {
@@ -816,6 +893,9 @@ void GraphicElements::startCurrentGame()
 
   hideKeyLayout();
 
+  // The game may depend on PREPARE lines still running
+  CommandQueue::prepare().wait();
+
   SDL_QuitSubSystem(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_TIMER);
   d->_screen = NULL;
   Mix_FreeChunk(d->_bling);
@@ -896,14 +976,10 @@ void GraphicElements::flip()
   SDL_Flip( d->_screen );
 }
 
-void GraphicElements::setDevice(const string& device)
+void GraphicElements::setDevice(const string& device, int count)
 {
   hideKeyLayout();
-  string actualDevice = device.empty() ? TEXT_ALL : device;
-  d->_elements._deviceElements._deviceName.setText(actualDevice.c_str(), d->_elements._fonts._entriesFont,
-                                                   d->_elements._fonts._entriesColor2,
-                                                   false,
-                                                   d->_parameters._filterXOffset + 150, d->_parameters._filterYOffset);
+  d->showFilter(Private::FILTER_DEVICE, device, count);
 
   d->_elements._deviceElements._deviceSelectedTargetFrame = d->_frame + 5;
   d->bump();
@@ -911,44 +987,68 @@ void GraphicElements::setDevice(const string& device)
     d->bling();
 }
 
-void GraphicElements::setType(const string& type)
+void GraphicElements::setType(const string& type, int count)
 {
   hideKeyLayout();
-  string actualType = type.empty() ? TEXT_ALL : type;
-  d->_elements._typeElements._typeName.setText(actualType.c_str(), d->_elements._fonts._entriesFont,
-                                                   d->_elements._fonts._entriesColor2,
-                                                   false,
-                                                   d->_parameters._filterXOffset + 150, d->_parameters._filterYOffset + d->_parameters._filterYPadding);
+  d->showFilter(Private::FILTER_TYPE, type, count);
   d->_elements._typeElements._typeSelectedTargetFrame = d->_frame + 5;
   d->bump();
   if(type.empty())
     d->bling();
 }
 
-void GraphicElements::setMulti(const string& multi)
+void GraphicElements::setMulti(const string& multi, int count)
 {
   hideKeyLayout();
   string actualMulti = multi.empty() ? "1P/2P/3P" : multi;
-  d->_elements._multiElements._multiName.setText(actualMulti.c_str(), d->_elements._fonts._entriesFont,
-                                                   d->_elements._fonts._entriesColor2,
-                                                   false,
-                                                   d->_parameters._filterXOffset + 150, d->_parameters._filterYOffset + 2 * d->_parameters._filterYPadding);
+  d->showFilter(Private::FILTER_MULTI, multi, count);
   d->_elements._multiElements._multiSelectedTargetFrame = d->_frame + 5;
   d->bump();
   if(actualMulti == "1P/2P" )
     d->bling();
 }
 
-void GraphicElements::setFamily(const string& family)
+void GraphicElements::setFamily(const string& family, int count)
 {
   hideKeyLayout();
-  string actualFamily = family.empty() ? TEXT_ALL : family;
-  d->_elements._familyElements._familyName.setText(actualFamily.c_str(), d->_elements._fonts._entriesFont,
-                                                   d->_elements._fonts._entriesColor2,
-                                                   false,
-                                                   d->_parameters._filterXOffset + 150, d->_parameters._filterYOffset + 3 * d->_parameters._filterYPadding);
+  d->showFilter(Private::FILTER_FAMILY, family, count);
   d->_elements._familyElements._familySelectedTargetFrame = d->_frame + 5;
   d->bump();
   if(family.empty())
     d->bling();
 }
+
+void GraphicElements::setSearch(bool searching, const string& text)
+{
+  d->_searching = searching;
+  if(!searching)
+  {
+    d->drawTitle(d->_collectionLabel);
+    return;
+  }
+
+  d->drawTitle(string(TEXT_SEARCH) + " : " + text + "_");
+}
+
+void GraphicElements::setCollection(const string& collection, int count)
+{
+  hideKeyLayout();
+  d->showCollection(collection, count);
+  d->bump();
+  if(collection.empty())
+    d->bling();
+}
+
+void GraphicElements::showFilters(const string& device,
+                                  const string& type,
+                                  const string& multi,
+                                  const string& family,
+                                  const string& collection)
+{
+  d->drawFilter(Private::FILTER_DEVICE, device, -1);
+  d->drawFilter(Private::FILTER_TYPE, type, -1);
+  d->drawFilter(Private::FILTER_MULTI, multi, -1);
+  d->drawFilter(Private::FILTER_FAMILY, family, -1);
+  d->_countedFilter = -1;
+  d->showCollection(collection, -1);
+}
@@ -8,7 +8,7 @@
 #include <vector>
 #include <string>
 
-class Game;
+class Selection;
 
 class GraphicElements
 {
@@ -21,15 +21,27 @@ class GraphicElements
     bool quit();
 
     void setCurrentFrame(unsigned int frame);
-    void setVisibleGames(const std::vector<Game*>& games, unsigned int cursorPosition);
+    void setVisibleGames(const Selection& games, unsigned int cursorPosition);
     void startCurrentGame();
     void showKeyLayout();
     void hideKeyLayout();
 
-    void setDevice(const std::string& device);
-    void setType(const std::string& type);
-    void setMulti(const std::string& multi);
-    void setFamily(const std::string& family);
+    // count, when given, is shown next to the value
+    void setDevice(const std::string& device, int count = -1);
+    void setType(const std::string& type, int count = -1);
+    void setMulti(const std::string& multi, int count = -1);
+    void setFamily(const std::string& family, int count = -1);
+    // Search text above the games, hidden when not searching
+    void setSearch(bool searching, const std::string& text);
+    // Saved collection shown above the games when not searching, hidden
+    // when empty
+    void setCollection(const std::string& collection, int count = -1);
+    // Redraws the filter values without animation nor sound
+    void showFilters(const std::string& device,
+                     const std::string& type,
+                     const std::string& multi,
+                     const std::string& family,
+                     const std::string& collection);
 
 //    void blinkDevice();
 //    void blinkType();
@@ -13,18 +13,22 @@ class GraphicStatus::Private
     Private();
     ~Private();
 
-    vector<Game*> _currentGames;
-    vector<Game*> _gamesInCurrentPage;
+    Selection _currentGames;
+    Selection _gamesInCurrentPage;
     unsigned int _currentGameIndex;
+    GraphicStatus::CursorMode _cursorMode;
 
     void offsetCurrentGameIndex(int offset);
+    // Index of the game at position, or of the game after it
+    unsigned int findGame(unsigned int position, bool& found) const;
     void recomputeCurrentPage();
 };
 
 GraphicStatus::Private::Private():
   _currentGames(),
   _gamesInCurrentPage(),
-  _currentGameIndex(0)
+  _currentGameIndex(0),
+  _cursorMode(CURSOR_STICKS_TO_GAME ? GraphicStatus::SAME_GAME : GraphicStatus::NEXT_GAME)
 {
 
 }
@@ -48,18 +52,42 @@ void GraphicStatus::Private::offsetCurrentGameIndex(int offset)
   recomputeCurrentPage();
 }
 
-void GraphicStatus::Private::recomputeCurrentPage()
+unsigned int GraphicStatus::Private::findGame(unsigned int position, bool& found) const
 {
-  _gamesInCurrentPage.clear();
-
-  unsigned int pageIndex = _currentGameIndex / NUM_GAMES;
-
-  for(unsigned int ii = pageIndex * NUM_GAMES;
-      ii < (pageIndex+1) * NUM_GAMES && ii < _currentGames.size();
-      ++ii)
+  const GameTable* games = _currentGames.getTable();
+  const unsigned int* iter = _currentGames.begin();
+  const unsigned int* end = _currentGames.end();
+  if(_currentGames.isRanked())
   {
-    _gamesInCurrentPage.push_back(_currentGames[ii]);
+    while(iter != end && games->position(*iter) != position)
+      ++iter;
+  }
+  else
+  {
+    // Lower bound: games are in the order of their positions
+    unsigned int count = end - iter;
+    while(count > 0)
+    {
+      unsigned int step = count / 2;
+      if(games->position(iter[step]) < position)
+      {
+        iter += step + 1;
+        count -= step + 1;
+      }
+      else
+      {
+        count = step;
+      }
+    }
   }
+  found = iter != end && games->position(*iter) == position;
+  return iter - _currentGames.begin();
+}
+
+void GraphicStatus::Private::recomputeCurrentPage()
+{
+  unsigned int pageIndex = _currentGameIndex / NUM_GAMES;
+  _gamesInCurrentPage = _currentGames.slice(pageIndex * NUM_GAMES, NUM_GAMES);
 }
 
 GraphicStatus::GraphicStatus():
@@ -82,34 +110,36 @@ bool GraphicStatus::quit()
   return true;
 }
 
-void GraphicStatus::setCurrentGames(const vector<Game*>& currentSelection)
+void GraphicStatus::setCursorMode(CursorMode mode)
+{
+  d->_cursorMode = mode;
+}
+
+void GraphicStatus::setCurrentGames(const Selection& currentSelection)
 {
   unsigned int currentPosition(0);
   if(!d->_currentGames.empty() && d->_currentGameIndex < d->_currentGames.size())
   {
-    currentPosition = d->_currentGames[d->_currentGameIndex]->getPosition();
+    currentPosition = d->_currentGames.game(d->_currentGameIndex).getPosition();
   }
 
-  d->_currentGames.clear();
-  d->_gamesInCurrentPage.clear();
+  setCurrentGames(currentSelection, currentPosition);
+}
 
+void GraphicStatus::setCurrentGames(const Selection& currentSelection, unsigned int currentPosition)
+{
   d->_currentGames = currentSelection;
+
   bool found(false);
-  for(unsigned int ii = 0; !found && ii < d->_currentGames.size(); ++ii)
-  {
-    if(d->_currentGames[ii]->getPosition() >= currentPosition)
-    {
-      found = true;
-      d->_currentGameIndex = ii;
-    }
-  }
-  if(!found)
-  {
-    if(d->_currentGames.empty())
-      d->_currentGameIndex=0;
-    else
-      d->_currentGameIndex = d->_currentGames.size() - 1;
-  }
+  unsigned int index(0);
+  if(!d->_currentGames.isRanked() || d->_cursorMode == SAME_GAME)
+    index = d->findGame(currentPosition, found);
+  if(!found && (d->_cursorMode == SAME_GAME || d->_currentGames.isRanked()))
+    index = 0;
+  if(index >= d->_currentGames.size())
+    index = d->_currentGames.empty() ? 0 : d->_currentGames.size() - 1;
+
+  d->_currentGameIndex = index;
   d->recomputeCurrentPage();
 }
 
@@ -133,7 +163,22 @@ void GraphicStatus::previousGame()
   d->offsetCurrentGameIndex(-1);
 }
 
-const vector<Game*>& GraphicStatus::getDisplayedGames() const
+void GraphicStatus::nextLetter()
+{
+  // The letters come with the games: nothing is computed here
+  unsigned int index = d->_currentGames.nextSection(d->_currentGameIndex);
+  if(index < d->_currentGames.size())
+    d->_currentGameIndex = index;
+  d->recomputeCurrentPage();
+}
+
+void GraphicStatus::previousLetter()
+{
+  d->_currentGameIndex = d->_currentGames.previousSection(d->_currentGameIndex);
+  d->recomputeCurrentPage();
+}
+
+const Selection& GraphicStatus::getDisplayedGames() const
 {
   return d->_gamesInCurrentPage;
 }
@@ -145,7 +190,9 @@ unsigned int GraphicStatus::getGameIndexInPage() const
   return d->_currentGameIndex % NUM_GAMES;
 }
 
-Game* GraphicStatus::getCurrentGame() const
+Game GraphicStatus::getCurrentGame() const
 {
-  return d->_currentGames[d->_currentGameIndex];
+  if(d->_currentGameIndex >= d->_currentGames.size())
+    return Game();
+  return d->_currentGames.game(d->_currentGameIndex);
 }
@@ -1,9 +1,8 @@
 #ifndef GRAPHICSTATUS_H
 #define GRAPHICSTATUS_H
 
-#include <vector>
-
-class Game;
+#include "Content.h"
+#include "Selection.h"
 
 class GraphicStatus
 {
@@ -15,16 +14,36 @@ class GraphicStatus
 
     bool quit();
 
-    void setCurrentGames(const std::vector<Game*>& currentSelection);
+    // Where the cursor goes when the games change
+    enum CursorMode
+    {
+      // On the highlighted game, or on the next one if it is gone
+      NEXT_GAME,
+      // On the highlighted game, or back to the first one if it is gone
+      SAME_GAME
+    };
+    void setCursorMode(CursorMode mode);
+
+    void setCurrentGames(const Selection& currentSelection);
+    // Cursor on the game at currentPosition, a position in the sort order of
+    // the games, or as set by the cursor mode.
+    // Ranked games start on the first one, unless sticking to the same game.
+    void setCurrentGames(const Selection& currentSelection, unsigned int currentPosition);
 
     void nextPage();
     void previousPage();
     void nextGame();
     void previousGame();
+    // First game of the next letter, or of the current one when the cursor
+    // is not on its first game. Letters of ranked games are not known.
+    void nextLetter();
+    void previousLetter();
 
-    const std::vector<Game*>& getDisplayedGames() const;
+    // Slice of the current games
+    const Selection& getDisplayedGames() const;
     unsigned int getGameIndexInPage() const;
-    Game* getCurrentGame() const;
+    // Not valid if no game is selected
+    Game getCurrentGame() const;
 
   private:
     class Private;
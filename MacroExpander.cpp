@@ -0,0 +1,128 @@
+#include "MacroExpander.h"
+
+using namespace std;
+
+MacroExpander::MacroExpander():
+  _roots(256, -1),
+  _nodes(),
+  _values(),
+  _forward()
+{}
+
+int MacroExpander::findChild(int node, char character) const
+{
+  for(int child = _nodes[node].child; child >= 0; child = _nodes[child].sibling)
+  {
+    if(_nodes[child].character == character)
+      return child;
+  }
+  return -1;
+}
+
+void MacroExpander::define(string_view name, string_view value)
+{
+  if(name.empty())
+    return;
+
+  string expanded;
+  expand(value, expanded);
+
+  unsigned char first = name[0];
+  if(_roots[first] < 0)
+  {
+    Node node = {name[0], -1, -1, -1};
+    _roots[first] = _nodes.size();
+    _nodes.push_back(node);
+  }
+
+  int current = _roots[first];
+  for(unsigned int ii = 1; ii < name.size(); ++ii)
+  {
+    int child = findChild(current, name[ii]);
+    if(child < 0)
+    {
+      Node node = {name[ii], -1, _nodes[current].child, -1};
+      child = _nodes.size();
+      _nodes.push_back(node);
+      _nodes[current].child = child;
+    }
+    current = child;
+  }
+
+  if(_nodes[current].macro < 0)
+  {
+    for(unsigned int ii = 0; ii < _values.size(); ++ii)
+    {
+      if(_values[ii].find(name) != string::npos)
+        _forward[ii] = true;
+    }
+    _nodes[current].macro = _values.size();
+    _values.push_back(expanded);
+    _forward.push_back(false);
+  }
+}
+
+void MacroExpander::clear()
+{
+  _roots.assign(256, -1);
+  _nodes.clear();
+  _values.clear();
+  _forward.clear();
+}
+
+bool MacroExpander::empty() const
+{
+  return _values.empty();
+}
+
+void MacroExpander::expand(string_view str, string& result) const
+{
+  result.clear();
+  expand(str, 0, result);
+}
+
+void MacroExpander::expand(string_view str, unsigned int firstMacro, string& result) const
+{
+  size_t copied(0);
+  size_t pos(0);
+  while(pos < str.size())
+  {
+    int node = _roots[(unsigned char) str[pos]];
+    if(node < 0)
+    {
+      ++pos;
+      continue;
+    }
+
+    // Longest macro name starting at pos
+    int macro(-1);
+    size_t macroEnd(0);
+    size_t end = pos + 1;
+    while(node >= 0)
+    {
+      if(_nodes[node].macro >= (int) firstMacro)
+      {
+        macro = _nodes[node].macro;
+        macroEnd = end;
+      }
+      if(end >= str.size())
+        break;
+      node = findChild(node, str[end++]);
+    }
+
+    if(macro < 0)
+    {
+      ++pos;
+      continue;
+    }
+
+    result.append(str.data() + copied, pos - copied);
+    if(_forward[macro])
+      expand(_values[macro], macro + 1, result);
+    else
+      result.append(_values[macro]);
+    pos = copied = macroEnd;
+  } // end while(pos < str.size())
+
+  result.append(str.data() + copied, str.size() - copied);
+}
@@ -0,0 +1,48 @@
+#ifndef MACROEXPANDER_H
+#define MACROEXPANDER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Macros defined by the MACRO lines of the catalog, compiled into a trie
+// so that a field is expanded in a single left-to-right pass: at each
+// position the longest macro name found there is replaced. As when the
+// macros were applied in turn, a value naming macros defined after it is
+// expanded again with those.
+class MacroExpander
+{
+  public:
+    MacroExpander();
+
+    // The value is expanded with the macros already defined. As before,
+    // when a name is defined twice the first definition wins.
+    void define(std::string_view name, std::string_view value);
+    void clear();
+    bool empty() const;
+
+    // Replaces the content of result
+    void expand(std::string_view str, std::string& result) const;
+
+  private:
+    struct Node
+    {
+      char character;
+      int child;
+      int sibling;
+      int macro;
+    };
+
+    int findChild(int node, char character) const;
+    // Appends str to result, expanding the macros from firstMacro on
+    void expand(std::string_view str, unsigned int firstMacro, std::string& result) const;
+
+    // Trie nodes whose first character is c start at _roots[c]
+    std::vector<int> _roots;
+    std::vector<Node> _nodes;
+    std::vector<std::string> _values;
+    // Values naming a macro defined after them
+    std::vector<bool> _forward;
+};
+
+#endif // MACROEXPANDER_H
@@ -0,0 +1,106 @@
+#include "NameIndex.h"
+
+#include "Collation.h"
+#include "GameTable.h"
+
+using namespace std;
+
+NameIndex::NameIndex()
+{
+  clear();
+}
+
+void NameIndex::clear()
+{
+  _names.clear();
+  _offsets.assign(1, 0);
+  _rows.clear();
+}
+
+void NameIndex::build(const GameTable& games)
+{
+  clear();
+
+  // Normalized names in row order, then sorted
+  string names, normalized;
+  vector<size_t> offsets(1, 0);
+  vector<unsigned int> rows;
+  for(unsigned int ii = 0; ii < games.size(); ++ii)
+  {
+    normalized.clear();
+    Collation::normalize(games.name(ii), normalized);
+    names.append(normalized);
+    offsets.push_back(names.size());
+    rows.push_back(ii);
+
+    string_view stripped = Collation::stripArticle(normalized);
+    if(stripped.size() != normalized.size())
+    {
+      names.append(stripped);
+      offsets.push_back(names.size());
+      rows.push_back(ii);
+    }
+  }
+
+  vector<string_view> keys;
+  keys.reserve(rows.size());
+  for(unsigned int ii = 0; ii < rows.size(); ++ii)
+    keys.push_back(string_view(names).substr(offsets[ii], offsets[ii + 1] - offsets[ii]));
+
+  vector<unsigned int> order(rows.size());
+  for(unsigned int ii = 0; ii < order.size(); ++ii)
+    order[ii] = ii;
+  Collation::sort(keys, order);
+
+  _names.reserve(names.size());
+  _offsets.reserve(order.size() + 1);
+  _rows.reserve(order.size());
+  for(unsigned int ii = 0; ii < order.size(); ++ii)
+  {
+    _names.append(keys[order[ii]]);
+    _offsets.push_back(_names.size());
+    _rows.push_back(rows[order[ii]]);
+  }
+}
+
+unsigned int NameIndex::size() const
+{
+  return _rows.size();
+}
+
+void NameIndex::narrow(string_view prefix, unsigned int& first, unsigned int& last) const
+{
+  // Entries are sorted: those starting with prefix are the ones whose
+  // first prefix.size() characters are neither before nor after it
+  unsigned int low(first), high(last);
+  while(low < high)
+  {
+    unsigned int middle = low + (high - low) / 2;
+    if(name(middle).substr(0, prefix.size()) < prefix)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  first = low;
+
+  high = last;
+  while(low < high)
+  {
+    unsigned int middle = low + (high - low) / 2;
+    if(name(middle).substr(0, prefix.size()) == prefix)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  last = low;
+}
+
+string_view NameIndex::name(unsigned int entry) const
+{
+  return string_view(_names).substr(_offsets[entry], _offsets[entry + 1] - _offsets[entry]);
+}
+
+unsigned int NameIndex::row(unsigned int entry) const
+{
+  return _rows[entry];
+}
@@ -0,0 +1,38 @@
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+
+class GameTable;
+
+// Game names normalized by Collation, in sorted order: the games whose
+// name starts with a given prefix are a range of entries. A name starting
+// with an article is also found without it.
+class NameIndex
+{
+  public:
+    NameIndex();
+
+    void clear();
+    void build(const GameTable& games);
+    unsigned int size() const;
+
+    // Narrows [first, last) to the entries starting with prefix. All
+    // entries of [first, last) must start with prefix minus its last
+    // characters: each character typed narrows the previous range.
+    void narrow(std::string_view prefix, unsigned int& first, unsigned int& last) const;
+
+    std::string_view name(unsigned int entry) const;
+    unsigned int row(unsigned int entry) const;
+
+  private:
+    std::string _names;
+    // Entry ii is _names[_offsets[ii]] to _names[_offsets[ii+1]]
+    std::vector<uint32_t> _offsets;
+    std::vector<unsigned int> _rows;
+};
+
+#endif // NAMEINDEX_H
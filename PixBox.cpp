@@ -6,6 +6,18 @@ using namespace std;
 
 PixBox* PixBox::_instance = NULL;
 
+// Keys typed into the search text: the quit (0), start (1 to 3) and coin
+// (5 to 8) keys of the panel keep their role
+static bool isSearchKey(SDLKey key)
+{
+  if(key >= SDLK_a && key <= SDLK_z)
+    return true;
+  return key == SDLK_4 ||
+         key == SDLK_9 ||
+         key == SDLK_SPACE ||
+         key == SDLK_BACKSPACE;
+}
+
 PixBox::PixBox():
   _graphics(new GraphicElements),
   _status(new GraphicStatus),
@@ -32,6 +44,7 @@ PixBox* PixBox::instance()
 bool PixBox::init(bool isQuiet)
 {
   _isQuiet = isQuiet;
+  IsQuiet = isQuiet;
   bool res = _graphics->init();
   res = _status->init() && res;
   res = _content->init() && res;
@@ -66,6 +79,23 @@ void PixBox::mainLoop()
     unsigned int frame = frameNumber();
     _graphics->setCurrentFrame(frame);
     bool update = true;
+
+    // Catalog file edited: swap catalogs between frames, keeping the
+    // filters and the highlighted game
+    Game currentGame = _status->getCurrentGame();
+    if(_content->publishReloadedCatalog())
+    {
+      unsigned int position = currentGame.isValid() ? _content->findPosition(currentGame) : 0;
+      _status->setCurrentGames(_content->currentSelection(), position);
+      _content->releasePreviousCatalog();
+      _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
+      _graphics->showFilters(_content->currentDevice(),
+                             _content->currentGameType(),
+                             _content->currentMultiplayer(),
+                             _content->currentGameFamily(),
+                             _content->currentCollection());
+    }
+
     //Handle events on queue
     bool escapeDown(false), coinDown(false);
     while( SDL_PollEvent( &e ) != 0 )
@@ -74,10 +104,74 @@ void PixBox::mainLoop()
       {
         quitRequested = true;
       }
+      else if( e.type == SDL_KEYDOWN &&
+               _content->isSearching() &&
+               isSearchKey(e.key.keysym.sym))
+      {
+        // Type-ahead search: each key narrows the selection
+        if(e.key.keysym.sym == SDLK_BACKSPACE)
+          _content->removeFromSearch();
+        else
+          _content->appendToSearch((char) e.key.keysym.sym);
+        update = true;
+        _status->setCurrentGames(_content->currentSelection());
+        _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
+        _graphics->setSearch(true, _content->searchText());
+      }
       else if( e.type == SDL_KEYDOWN )
       {
         switch( e.key.keysym.sym )
         {
+          case SDLK_TAB:
+            {
+              if(_content->isSearching())
+                _content->stopSearch();
+              else
+                _content->startSearch();
+              update = true;
+              _status->setCurrentGames(_content->currentSelection());
+              _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
+              _graphics->setSearch(_content->isSearching(), _content->searchText());
+            }
+            break;
+
+          case SDLK_F1:
+            {
+              // Same games in the next order, the cursor on the same game
+              _content->nextSortOrder();
+              update = true;
+              _status->setCurrentGames(_content->currentSelection());
+              _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
+            }
+            break;
+
+          case SDLK_F2:
+            {
+              string collection = this->_content->nextCollection();
+              update = true;
+              _status->setCurrentGames(_content->currentSelection());
+              _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
+              _graphics->setCollection(collection, _content->currentCollectionCount());
+            }
+            break;
+
+          case SDLK_F3:
+            {
+              string collection = this->_content->previousCollection();
+              update = true;
+              _status->setCurrentGames(_content->currentSelection());
+              _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
+              _graphics->setCollection(collection, _content->currentCollectionCount());
+            }
+            break;
+
+          case SDLK_RETURN:
+            {
+              update=true;
+              _graphics->startCurrentGame();
+            }
+            break;
+
           case SDLK_0:
             {
               quitRequested = true;
@@ -92,7 +186,7 @@ void PixBox::mainLoop()
               update = true;
               _status->setCurrentGames(_content->currentSelection());
               _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
-              _graphics->setDevice(device);
+              _graphics->setDevice(device, _content->currentDeviceCount());
             }
             break;
 
@@ -104,7 +198,7 @@ void PixBox::mainLoop()
               update = true;
               _status->setCurrentGames(_content->currentSelection());
               _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
-              _graphics->setDevice(device);
+              _graphics->setDevice(device, _content->currentDeviceCount());
             }
             break;
 
@@ -116,7 +210,7 @@ void PixBox::mainLoop()
               update = true;
               _status->setCurrentGames(_content->currentSelection());
               _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
-              _graphics->setType(type);
+              _graphics->setType(type, _content->currentGameTypeCount());
             }
             break;
 
@@ -128,7 +222,7 @@ void PixBox::mainLoop()
               update = true;
               _status->setCurrentGames(_content->currentSelection());
               _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
-              _graphics->setType(type);
+              _graphics->setType(type, _content->currentGameTypeCount());
             }
 
           case SDLK_d: // Player 1
@@ -139,7 +233,7 @@ void PixBox::mainLoop()
               update = true;
               _status->setCurrentGames(_content->currentSelection());
               _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
-              _graphics->setMulti(multiplayer);
+              _graphics->setMulti(multiplayer, _content->currentMultiplayerCount());
             }
             break;
 
@@ -151,7 +245,7 @@ void PixBox::mainLoop()
               update = true;
               _status->setCurrentGames(_content->currentSelection());
               _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
-              _graphics->setMulti(multiplayer);
+              _graphics->setMulti(multiplayer, _content->currentMultiplayerCount());
             }
             break;
 
@@ -163,7 +257,7 @@ void PixBox::mainLoop()
               update = true;
               _status->setCurrentGames(_content->currentSelection());
               _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
-              _graphics->setFamily(family);
+              _graphics->setFamily(family, _content->currentGameFamilyCount());
             }
             break;
 
@@ -175,7 +269,7 @@ void PixBox::mainLoop()
               update = true;
               _status->setCurrentGames(_content->currentSelection());
               _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
-              _graphics->setFamily(family);
+              _graphics->setFamily(family, _content->currentGameFamilyCount());
             }
             break;
 
@@ -235,6 +329,30 @@ void PixBox::mainLoop()
             }
             break;
 
+          case SDLK_PAGEUP:
+            {
+              if(frameNumber() - lastProcessedEventFrame > EVENT_THRESHOLD_IN_FRAMES)
+              {
+                update=true;
+                _status->previousLetter();
+                _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
+                lastProcessedEventFrame = frameNumber();
+              }
+            }
+            break;
+
+          case SDLK_PAGEDOWN:
+            {
+              if(frameNumber() - lastProcessedEventFrame > EVENT_THRESHOLD_IN_FRAMES)
+              {
+                update=true;
+                _status->nextLetter();
+                _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
+                lastProcessedEventFrame = frameNumber();
+              }
+            }
+            break;
+
           case SDLK_1: // Player 1
           case SDLK_2: // Player 2
             case SDLK_3: // Player 3
@@ -253,6 +371,15 @@ void PixBox::mainLoop()
           case SDLK_5:
             {
               update=true;
+              // The panel has no TAB: coin leaves the search
+              if(_content->isSearching())
+              {
+                _content->stopSearch();
+                _status->setCurrentGames(_content->currentSelection());
+                _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
+                _graphics->setSearch(false, _content->searchText());
+                break;
+              }
 //              _status->nextPage();
 //              _graphics->setVisibleGames(_status->getDisplayedGames(), _status->getGameIndexInPage());
               _graphics->showKeyLayout();
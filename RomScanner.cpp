@@ -0,0 +1,1137 @@
+#include "RomScanner.h"
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#ifndef WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#include "CatalogReader.h"
+#include "Crc32.h"
+#include "MacroExpander.h"
+#include "defines.h"
+
+using namespace std;
+
+#define CHECKSUM_CACHE_HEADER "PIXBOX-CRC 1"
+#define READ_BLOCK_SIZE (1024 * 1024)
+
+// Zip records, all fields little-endian
+#define ZIP_END_SIGNATURE 0x06054b50u
+#define ZIP_END_SIZE 22
+#define ZIP_MAX_COMMENT 65535
+#define ZIP_ENTRY_SIGNATURE 0x02014b50u
+#define ZIP_ENTRY_SIZE 46
+
+// Catalog fields
+#define FIELD_DEVICE 4
+#define FIELD_ARTWORK 7
+#define FIELD_COMMAND 8
+#define NUM_FIELDS 9
+
+class RomScanner::Private
+{
+  public:
+    Private();
+    ~Private(){}
+
+    struct Directory
+    {
+      // Ends with '/'
+      string path;
+      string macro;
+      // Learnt from the rows of the directory
+      string device;
+      string artMacro;
+      // The emulator is given the name of the game rather than its file,
+      // as gngeo with --rompath
+      bool byName;
+    };
+
+    struct Row
+    {
+      vector<string> fields;
+      int directory;
+      // ROM file, relative to the directory
+      string file;
+    };
+
+    struct Member
+    {
+      uint32_t crc;
+      uint64_t size;
+      string name;
+    };
+
+    struct File
+    {
+      string path;
+      uint64_t size;
+      int64_t mtime;
+      bool archive;
+      bool checksummed;
+      uint32_t crc;
+      vector<Member> members;
+      // Database game, -1 if unknown
+      int game;
+      // Catalog directory holding the file, -1 if none
+      int directory;
+      bool referenced;
+    };
+
+    struct Game
+    {
+      string name;
+      string description;
+      // Catalog fields of a CSV database, from the title to the family
+      vector<string> fields;
+    };
+
+    struct Rom
+    {
+      uint64_t size;
+      unsigned int game;
+    };
+
+    struct Walk
+    {
+      Private* scanner;
+      mutex lock;
+      condition_variable changed;
+      deque<string> pending;
+      set<string> seen;
+      // Directories being read
+      unsigned int busy;
+    };
+
+    struct Checksums
+    {
+      Private* scanner;
+      const vector<unsigned int>* files;
+      mutex lock;
+      unsigned int next;
+      unsigned long long bytesRead;
+    };
+
+    bool loadDat(CatalogReader& reader);
+    bool loadCsv(CatalogReader& reader);
+    int addGame(const string& name);
+    void addRom(uint32_t crc, uint64_t size, unsigned int game, const string& name);
+
+    void walk(unsigned int numThreads);
+    void loadCache(const string& path);
+    void saveCache(const string& path) const;
+    static void checksum(File& file, vector<char>& buffer, unsigned long long& bytesRead);
+    static bool readZip(File& file, unsigned long long& bytesRead);
+    void identify(File& file);
+    void match();
+    void appendRow(const vector<string>& fields, string& rows) const;
+    void makeRow(const File& file, vector<string>& fields) const;
+
+    static void walkQueuedDirectories(Walk* walk);
+    static void walkDirectory(const string& path, vector<string>& directories, vector<File>& files);
+    static void checksumQueuedFiles(Checksums* checksums);
+    static bool earlierPath(const File& first, const File& second);
+    static bool samePath(const File& first, const File& second);
+    static string lower(string_view str);
+    static string trim(string_view str);
+    static string stem(const string& file);
+    static string cleanTitle(const string& description);
+    static string slug(const string& title);
+
+    vector<Directory> _directories;
+    vector<string> _extraDirectories;
+    vector<Row> _rows;
+
+    vector<Game> _games;
+    unordered_multimap<uint32_t, Rom> _roms;
+    // Game and ROM names, lower case and without extension
+    unordered_map<string, unsigned int> _gamesByName;
+
+    vector<File> _files;
+    unordered_map<string, File> _cache;
+
+    // Results
+    string _relocatedRows;
+    string _newRows;
+    vector<string> _missing;
+    vector<string> _unidentified;
+    vector<string> _elsewhere;
+    Stats _stats;
+};
+
+RomScanner::Private::Private():
+  _directories(),
+  _extraDirectories(),
+  _rows(),
+  _games(),
+  _roms(),
+  _gamesByName(),
+  _files(),
+  _cache(),
+  _relocatedRows(),
+  _newRows(),
+  _missing(),
+  _unidentified(),
+  _elsewhere()
+{
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+string RomScanner::Private::lower(string_view str)
+{
+  string res(str);
+  for(unsigned int ii = 0; ii < res.size(); ++ii)
+    res[ii] = tolower((unsigned char) res[ii]);
+  return res;
+}
+
+string RomScanner::Private::trim(string_view str)
+{
+  size_t first = 0;
+  while(first < str.size() && isspace((unsigned char) str[first]))
+    ++first;
+  size_t last = str.size();
+  while(last > first && isspace((unsigned char) str[last - 1]))
+    --last;
+  return string(str.substr(first, last - first));
+}
+
+string RomScanner::Private::stem(const string& file)
+{
+  size_t slash = file.rfind('/');
+  size_t dot = file.rfind('.');
+  if(dot == string::npos || (slash != string::npos && dot < slash))
+    return file;
+  return file.substr(0, dot);
+}
+
+string RomScanner::Private::cleanTitle(const string& description)
+{
+  // "Sonic The Hedgehog (USA, Europe) [!]" is "Sonic The Hedgehog", and
+  // MAME titles lose their alternate title after " / "
+  string res(description);
+  size_t cut = res.find_first_of("([");
+  if(cut != string::npos && cut > 0)
+    res.erase(cut);
+  cut = res.find(" / ");
+  if(cut != string::npos)
+    res.erase(cut);
+  return trim(res);
+}
+
+string RomScanner::Private::slug(const string& title)
+{
+  string res;
+  for(unsigned int ii = 0; ii < title.size(); ++ii)
+  {
+    unsigned char character = title[ii];
+    if(isalnum(character))
+      res += tolower(character);
+    else if(!res.empty() && res[res.size() - 1] != '-' && character != '\'')
+      res += '-';
+  }
+  while(!res.empty() && res[res.size() - 1] == '-')
+    res.erase(res.size() - 1);
+  return res;
+}
+
+int RomScanner::Private::addGame(const string& name)
+{
+  Game game;
+  game.name = name;
+  _games.push_back(game);
+  return _games.size() - 1;
+}
+
+void RomScanner::Private::addRom(uint32_t crc, uint64_t size, unsigned int game, const string& name)
+{
+  Rom rom = {size, game};
+  _roms.insert(make_pair(crc, rom));
+  if(!name.empty())
+    _gamesByName.insert(make_pair(lower(stem(name)), game));
+}
+
+// XML is not parsed for real: the tags of a DAT file are one per line
+//   <game name="sonic">  (or <machine ...>)
+//     <description>Sonic The Hedgehog (USA, Europe)</description>
+//     <rom name="Sonic The Hedgehog (USA, Europe).md" size="524288" crc="f9394e97"/>
+bool RomScanner::Private::loadDat(CatalogReader& reader)
+{
+  string_view line;
+  int game(-1);
+  while(reader.nextLine(line))
+  {
+    string tag = trim(line);
+    if(tag.compare(0, 6, "<game ") == 0 || tag.compare(0, 9, "<machine ") == 0)
+    {
+      game = -1;
+      size_t name = tag.find("name=\"");
+      if(name != string::npos)
+      {
+        name += 6;
+        game = addGame(tag.substr(name, tag.find('"', name) - name));
+        _gamesByName.insert(make_pair(lower(_games[game].name), game));
+      }
+    }
+    else if(game >= 0 && tag.compare(0, 13, "<description>") == 0)
+    {
+      _games[game].description = tag.substr(13, tag.find("</description>") - 13);
+    }
+    else if(game >= 0 && tag.compare(0, 5, "<rom ") == 0)
+    {
+      string name, size, crc;
+      string* attributes[3] = {&name, &size, &crc};
+      const char* keys[3] = {" name=\"", " size=\"", " crc=\""};
+      for(unsigned int ii = 0; ii < 3; ++ii)
+      {
+        size_t start = tag.find(keys[ii]);
+        if(start == string::npos)
+          continue;
+        start += strlen(keys[ii]);
+        *attributes[ii] = tag.substr(start, tag.find('"', start) - start);
+      }
+      if(!crc.empty())
+        addRom(strtoul(crc.c_str(), NULL, 16), strtoull(size.c_str(), NULL, 10), game, name);
+    }
+  } // end while(reader.nextLine(line))
+
+  // Entities of the names and descriptions
+  const char* entities[5][2] = {{"&amp;", "&"}, {"&apos;", "'"}, {"&quot;", "\""}, {"&lt;", "<"}, {"&gt;", ">"}};
+  for(unsigned int ii = 0; ii < _games.size(); ++ii)
+  {
+    for(unsigned int entity = 0; entity < 5; ++entity)
+    {
+      size_t found(0);
+      string& description = _games[ii].description;
+      while((found = description.find(entities[entity][0], found)) != string::npos)
+      {
+        description.replace(found, strlen(entities[entity][0]), entities[entity][1]);
+        ++found;
+      }
+    }
+  } // end for(unsigned int ii = 0; ii < _games.size(); ++ii)
+  return !_roms.empty();
+}
+
+bool RomScanner::Private::loadCsv(CatalogReader& reader)
+{
+  string_view line;
+  vector<string_view> split;
+  while(reader.nextLine(line))
+  {
+    if(line.empty() || line[0] == '#')
+      continue;
+    CatalogReader::split(line, ';', split);
+    if(split.size() < 2)
+      continue;
+
+    char* end(NULL);
+    string crc(trim(split[0]));
+    uint32_t value = strtoul(crc.c_str(), &end, 16);
+    if(crc.empty() || *end != '\0')
+      continue;
+
+    unsigned int game = addGame(trim(split[1]));
+    for(unsigned int field = 1; field < split.size() && field < FIELD_ARTWORK + 1; ++field)
+      _games[game].fields.push_back(trim(split[field]));
+    _games[game].description = _games[game].name;
+    _gamesByName.insert(make_pair(lower(_games[game].name), game));
+    // Size unknown: any size matches
+    addRom(value, 0, game, string());
+  } // end while(reader.nextLine(line))
+  return !_roms.empty();
+}
+
+void RomScanner::Private::walkDirectory(const string& path, vector<string>& directories, vector<File>& files)
+{
+#ifndef WIN32
+  DIR* dir = opendir(path.c_str());
+  if(dir == NULL)
+    return;
+
+  struct dirent* entry;
+  while((entry = readdir(dir)) != NULL)
+  {
+    if(entry->d_name[0] == '.')
+      continue;
+
+    string child = path + entry->d_name;
+    struct stat status;
+    if(stat(child.c_str(), &status) != 0)
+      continue;
+
+    if(S_ISDIR(status.st_mode))
+    {
+      directories.push_back(child + '/');
+    }
+    else if(S_ISREG(status.st_mode))
+    {
+      File file;
+      file.path = child;
+      file.size = status.st_size;
+      file.mtime = status.st_mtime;
+      string name = lower(entry->d_name);
+      file.archive = name.size() > 4 && name.compare(name.size() - 4, 4, ".zip") == 0;
+      file.checksummed = false;
+      file.crc = 0;
+      file.game = -1;
+      file.directory = -1;
+      file.referenced = false;
+      files.push_back(file);
+    }
+  } // end while((entry = readdir(dir)) != NULL)
+  closedir(dir);
+#endif
+}
+
+void RomScanner::Private::walkQueuedDirectories(Walk* walk)
+{
+  vector<string> directories;
+  vector<File> files;
+  unique_lock<mutex> lock(walk->lock);
+  while(true)
+  {
+    while(walk->pending.empty() && walk->busy > 0)
+      walk->changed.wait(lock);
+    if(walk->pending.empty())
+      return;
+
+    string path;
+    path.swap(walk->pending.front());
+    walk->pending.pop_front();
+    ++walk->busy;
+    ++walk->scanner->_stats.directories;
+    lock.unlock();
+
+    directories.clear();
+    files.clear();
+    walkDirectory(path, directories, files);
+
+    lock.lock();
+    for(unsigned int ii = 0; ii < directories.size(); ++ii)
+    {
+      // A directory added is often a parent of a catalog directory
+      if(walk->seen.insert(directories[ii]).second)
+        walk->pending.push_back(directories[ii]);
+    }
+    walk->scanner->_files.insert(walk->scanner->_files.end(), files.begin(), files.end());
+    --walk->busy;
+    walk->changed.notify_all();
+  } // end while(true)
+}
+
+bool RomScanner::Private::earlierPath(const File& first, const File& second)
+{
+  return first.path < second.path;
+}
+
+bool RomScanner::Private::samePath(const File& first, const File& second)
+{
+  return first.path == second.path;
+}
+
+void RomScanner::Private::walk(unsigned int numThreads)
+{
+  // Directories are shared between the threads as they are found: on a slow
+  // card each readdir() and stat() waits for the card anyway
+  Walk walk;
+  walk.scanner = this;
+  walk.busy = 0;
+  for(unsigned int ii = 0; ii < _directories.size(); ++ii)
+  {
+    if(walk.seen.insert(_directories[ii].path).second)
+      walk.pending.push_back(_directories[ii].path);
+  }
+  for(unsigned int ii = 0; ii < _extraDirectories.size(); ++ii)
+  {
+    if(walk.seen.insert(_extraDirectories[ii]).second)
+      walk.pending.push_back(_extraDirectories[ii]);
+  }
+
+  vector<thread> threads;
+  for(unsigned int ii = 1; ii < numThreads; ++ii)
+    threads.push_back(thread(walkQueuedDirectories, &walk));
+  walkQueuedDirectories(&walk);
+  for(unsigned int ii = 0; ii < threads.size(); ++ii)
+    threads[ii].join();
+
+  // Two directories added may hold the same files
+  std::sort(_files.begin(), _files.end(), earlierPath);
+  _files.erase(std::unique(_files.begin(), _files.end(), samePath), _files.end());
+  _stats.files = _files.size();
+}
+
+// Text file, one line per file, each archive followed by its members:
+//   F <tab> size <tab> mtime <tab> crc <tab> path
+//   A <tab> size <tab> mtime <tab> path
+//   M <tab> crc <tab> size <tab> name
+void RomScanner::Private::loadCache(const string& path)
+{
+  CatalogReader reader;
+  if(path.empty() || !reader.open(path))
+    return;
+
+  string_view line;
+  if(!reader.nextLine(line) || line != CHECKSUM_CACHE_HEADER)
+    return;
+
+  vector<string_view> split;
+  File* archive(NULL);
+  while(reader.nextLine(line))
+  {
+    CatalogReader::split(line, '\t', split);
+    if(split.size() == 5 && split[0] == "F")
+    {
+      File& file = _cache[string(split[4])];
+      file.size = strtoull(string(split[1]).c_str(), NULL, 10);
+      file.mtime = strtoll(string(split[2]).c_str(), NULL, 10);
+      file.crc = strtoul(string(split[3]).c_str(), NULL, 16);
+      file.archive = false;
+      archive = NULL;
+    }
+    else if(split.size() == 4 && split[0] == "A")
+    {
+      archive = &_cache[string(split[3])];
+      archive->size = strtoull(string(split[1]).c_str(), NULL, 10);
+      archive->mtime = strtoll(string(split[2]).c_str(), NULL, 10);
+      archive->archive = true;
+      archive->members.clear();
+    }
+    else if(split.size() == 4 && split[0] == "M" && archive != NULL)
+    {
+      Member member = {(uint32_t) strtoul(string(split[1]).c_str(), NULL, 16),
+                       strtoull(string(split[2]).c_str(), NULL, 10),
+                       string(split[3])};
+      archive->members.push_back(member);
+    }
+  } // end while(reader.nextLine(line))
+}
+
+void RomScanner::Private::saveCache(const string& path) const
+{
+  if(path.empty())
+    return;
+
+  // Written aside, then renamed: a scan stopped halfway keeps the old cache
+  string temporary = path + ".tmp";
+  FILE* output = fopen(temporary.c_str(), "w");
+  if(output == NULL)
+    return;
+
+  fprintf(output, "%s\n", CHECKSUM_CACHE_HEADER);
+  for(unsigned int ii = 0; ii < _files.size(); ++ii)
+  {
+    const File& file = _files[ii];
+    if(!file.checksummed)
+      continue;
+
+    if(file.archive && !file.members.empty())
+    {
+      fprintf(output, "A\t%llu\t%lld\t%s\n", (unsigned long long) file.size, (long long) file.mtime, file.path.c_str());
+      for(unsigned int member = 0; member < file.members.size(); ++member)
+        fprintf(output, "M\t%08x\t%llu\t%s\n", file.members[member].crc, (unsigned long long) file.members[member].size, file.members[member].name.c_str());
+    }
+    else
+    {
+      fprintf(output, "F\t%llu\t%lld\t%08x\t%s\n", (unsigned long long) file.size, (long long) file.mtime, file.crc, file.path.c_str());
+    }
+  } // end for(unsigned int ii = 0; ii < _files.size(); ++ii)
+
+  if(fclose(output) == 0)
+    rename(temporary.c_str(), path.c_str());
+  else
+    remove(temporary.c_str());
+}
+
+namespace
+{
+  uint32_t read16(const unsigned char* data)
+  {
+    return data[0] | (data[1] << 8);
+  }
+
+  uint32_t read32(const unsigned char* data)
+  {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t) data[3] << 24);
+  }
+}
+
+bool RomScanner::Private::readZip(File& file, unsigned long long& bytesRead)
+{
+  // Only the central directory is read: it holds the CRC of every member
+  FILE* input = fopen(file.path.c_str(), "rb");
+  if(input == NULL)
+    return false;
+
+  vector<unsigned char> tail(std::min<uint64_t>(file.size, ZIP_END_SIZE + ZIP_MAX_COMMENT));
+  bool read = !tail.empty() &&
+              fseek(input, file.size - tail.size(), SEEK_SET) == 0 &&
+              fread(tail.data(), 1, tail.size(), input) == tail.size();
+  bytesRead += tail.size();
+
+  long end(-1);
+  for(long ii = (long) tail.size() - ZIP_END_SIZE; read && ii >= 0 && end < 0; --ii)
+  {
+    if(read32(&tail[ii]) == ZIP_END_SIGNATURE)
+      end = ii;
+  }
+
+  vector<unsigned char> entries;
+  if(end >= 0)
+  {
+    // Larger than 4 GB, or zip64: out of reach here
+    uint64_t size = read32(&tail[end + 12]);
+    uint64_t offset = read32(&tail[end + 16]);
+    if(size > 0 && offset + size <= file.size)
+    {
+      entries.resize(size);
+      read = fseek(input, offset, SEEK_SET) == 0 && fread(entries.data(), 1, size, input) == size;
+      bytesRead += size;
+    }
+  }
+  fclose(input);
+  if(entries.empty() || !read)
+    return false;
+
+  file.members.clear();
+  for(size_t offset = 0; offset + ZIP_ENTRY_SIZE <= entries.size() && read32(&entries[offset]) == ZIP_ENTRY_SIGNATURE;)
+  {
+    const unsigned char* entry = &entries[offset];
+    unsigned int nameLength = read16(entry + 28);
+    size_t next = offset + ZIP_ENTRY_SIZE + nameLength + read16(entry + 30) + read16(entry + 32);
+    if(next > entries.size())
+      break;
+
+    Member member = {read32(entry + 16),
+                     read32(entry + 24),
+                     string((const char*) entry + ZIP_ENTRY_SIZE, nameLength)};
+    // Directories
+    if(!member.name.empty() && member.name[member.name.size() - 1] != '/')
+      file.members.push_back(member);
+    offset = next;
+  } // end for(...)
+  return !file.members.empty();
+}
+
+void RomScanner::Private::checksum(File& file, vector<char>& buffer, unsigned long long& bytesRead)
+{
+  // Archives that can't be read as zips are checksummed as a whole
+  if(file.archive && readZip(file, bytesRead))
+  {
+    file.checksummed = true;
+    return;
+  }
+
+  FILE* input = fopen(file.path.c_str(), "rb");
+  if(input == NULL)
+    return;
+
+  uint32_t crc(0);
+  size_t read;
+  while((read = fread(buffer.data(), 1, buffer.size(), input)) > 0)
+  {
+    crc = Crc32::update(crc, buffer.data(), read);
+    bytesRead += read;
+  }
+  file.checksummed = !ferror(input);
+  file.crc = crc;
+  fclose(input);
+}
+
+void RomScanner::Private::checksumQueuedFiles(Checksums* checksums)
+{
+  vector<char> buffer(READ_BLOCK_SIZE);
+  unsigned long long bytesRead(0);
+  unique_lock<mutex> lock(checksums->lock);
+  while(checksums->next < checksums->files->size())
+  {
+    File& file = checksums->scanner->_files[(*checksums->files)[checksums->next++]];
+    lock.unlock();
+    checksum(file, buffer, bytesRead);
+    lock.lock();
+  }
+  checksums->bytesRead += bytesRead;
+}
+
+void RomScanner::Private::identify(File& file)
+{
+  file.game = -1;
+  if(!file.checksummed)
+    return;
+
+  if(file.members.empty())
+  {
+    pair<unordered_multimap<uint32_t, Rom>::const_iterator,
+         unordered_multimap<uint32_t, Rom>::const_iterator> range = _roms.equal_range(file.crc);
+    for(unordered_multimap<uint32_t, Rom>::const_iterator iter = range.first; iter != range.second && file.game < 0; ++iter)
+    {
+      if(iter->second.size == 0 || iter->second.size == file.size)
+        file.game = iter->second.game;
+    }
+    return;
+  }
+
+  // The game most members belong to: an arcade set shares ROMs with its
+  // clones and parent
+  map<unsigned int, unsigned int> votes;
+  unsigned int best(0);
+  string name = lower(stem(file.path.substr(file.path.rfind('/') + 1)));
+  for(unsigned int ii = 0; ii < file.members.size(); ++ii)
+  {
+    const Member& member = file.members[ii];
+    pair<unordered_multimap<uint32_t, Rom>::const_iterator,
+         unordered_multimap<uint32_t, Rom>::const_iterator> range = _roms.equal_range(member.crc);
+    set<unsigned int> games;
+    for(unordered_multimap<uint32_t, Rom>::const_iterator iter = range.first; iter != range.second; ++iter)
+    {
+      if(iter->second.size == 0 || iter->second.size == member.size)
+        games.insert(iter->second.game);
+    }
+    for(set<unsigned int>::const_iterator game = games.begin(); game != games.end(); ++game)
+    {
+      unsigned int count = ++votes[*game];
+      // Ties go to the game named as the archive
+      if(count > best || (count == best && lower(_games[*game].name) == name))
+      {
+        best = count;
+        file.game = *game;
+      }
+    }
+  } // end for(unsigned int ii = 0; ii < file.members.size(); ++ii)
+}
+
+void RomScanner::Private::appendRow(const vector<string>& fields, string& rows) const
+{
+  for(unsigned int ii = 0; ii < fields.size(); ++ii)
+  {
+    if(ii > 0)
+      rows += ';';
+    rows += fields[ii];
+  }
+  rows += '\n';
+}
+
+void RomScanner::Private::makeRow(const File& file, vector<string>& fields) const
+{
+  const Game& game = _games[file.game];
+  const Directory& directory = _directories[file.directory];
+  string suffix = lower(directory.macro.substr(1, directory.macro.size() - 2));
+
+  fields = game.fields;
+  fields.resize(FIELD_ARTWORK);
+  if(game.fields.empty())
+  {
+    fields[0] = cleanTitle(game.description.empty() ? game.name : game.description);
+    fields[2] = slug(fields[0]) + '-' + suffix;
+    fields[5] = "1";
+  }
+  if(fields[1].empty())
+  {
+    // Cut on a character boundary
+    size_t length = fields[0].size();
+    if(length > MAX_SHORTNAME_LENGTH)
+    {
+      length = MAX_SHORTNAME_LENGTH;
+      while(length > 0 && (fields[0][length] & 0xC0) == 0x80)
+        --length;
+    }
+    fields[1] = trim(fields[0].substr(0, length));
+  }
+  if(fields[2].empty())
+    fields[2] = slug(fields[0]) + '-' + suffix;
+  if(fields[FIELD_DEVICE].empty())
+    fields[FIELD_DEVICE] = directory.device;
+  fields.push_back(directory.artMacro.empty() ? string() : directory.artMacro + fields[2] + ".png");
+
+  string relative = file.path.substr(directory.path.size());
+  fields.push_back(directory.macro + (directory.byName ? stem(relative) : relative));
+}
+
+void RomScanner::Private::match()
+{
+  unordered_map<string, unsigned int> byPath;
+  unordered_map<string, unsigned int> byStem;
+  for(unsigned int ii = 0; ii < _files.size(); ++ii)
+  {
+    File& file = _files[ii];
+    byPath[file.path] = ii;
+    byStem.insert(make_pair(stem(file.path), ii));
+
+    // The innermost catalog directory holding the file
+    size_t longest(0);
+    for(unsigned int dir = 0; dir < _directories.size(); ++dir)
+    {
+      const string& path = _directories[dir].path;
+      if(path.size() > longest && file.path.compare(0, path.size(), path) == 0)
+      {
+        longest = path.size();
+        file.directory = dir;
+      }
+    }
+
+    identify(file);
+    if(file.game >= 0)
+      ++_stats.identified;
+    else if(!_roms.empty())
+      _unidentified.push_back(file.path);
+  } // end for(unsigned int ii = 0; ii < _files.size(); ++ii)
+  _stats.unidentified = _files.size() - _stats.identified;
+
+  // Rows whose file is there. gngeo rows name the game: "mslug" is mslug.zip
+  set<pair<int, int> > referenced;
+  vector<unsigned int> missing;
+  for(unsigned int ii = 0; ii < _rows.size(); ++ii)
+  {
+    const Row& row = _rows[ii];
+    if(row.directory < 0 || row.file.empty())
+      continue;
+
+    string path = _directories[row.directory].path + row.file;
+    unordered_map<string, unsigned int>::const_iterator found = byPath.find(path);
+    if(found == byPath.end())
+    {
+      found = byStem.find(path);
+      if(found == byStem.end())
+      {
+        missing.push_back(ii);
+        continue;
+      }
+    }
+
+    File& file = _files[found->second];
+    file.referenced = true;
+    if(file.game >= 0)
+      referenced.insert(make_pair(row.directory, file.game));
+  } // end for(unsigned int ii = 0; ii < _rows.size(); ++ii)
+
+  // Missing files may have been renamed: the file of the game of the same
+  // name, if the database knows it
+  vector<string> fields;
+  for(unsigned int ii = 0; ii < missing.size(); ++ii)
+  {
+    const Row& row = _rows[missing[ii]];
+    const Directory& directory = _directories[row.directory];
+    ++_stats.missing;
+
+    int game(-1);
+    unordered_map<string, unsigned int>::const_iterator name = _gamesByName.find(lower(stem(row.file)));
+    if(name != _gamesByName.end())
+      game = name->second;
+
+    int relocated(-1);
+    for(unsigned int file = 0; file < _files.size() && game >= 0 && relocated < 0; ++file)
+    {
+      if(_files[file].directory == row.directory && _files[file].game == game && !_files[file].referenced)
+        relocated = file;
+    }
+
+    const string& command = row.fields[FIELD_COMMAND];
+    if(relocated < 0 || command.size() < row.file.size())
+    {
+      _missing.push_back(row.fields[0] + " (" + row.fields[FIELD_DEVICE] + "): " + directory.path + row.file);
+      continue;
+    }
+
+    File& file = _files[relocated];
+    file.referenced = true;
+    referenced.insert(make_pair(row.directory, game));
+    ++_stats.relocated;
+
+    string relative = file.path.substr(directory.path.size());
+    fields = row.fields;
+    size_t position = command.rfind(row.file);
+    fields[FIELD_COMMAND] = command.substr(0, position) + (directory.byName ? stem(relative) : relative);
+    appendRow(fields, _relocatedRows);
+  } // end for(unsigned int ii = 0; ii < missing.size(); ++ii)
+
+  // Games of the catalog directories not in the catalog yet, one row per game
+  for(unsigned int ii = 0; ii < _files.size(); ++ii)
+  {
+    const File& file = _files[ii];
+    if(file.game < 0 || file.referenced)
+      continue;
+
+    if(file.directory < 0)
+    {
+      _elsewhere.push_back(file.path + ": " + cleanTitle(_games[file.game].description.empty() ? _games[file.game].name : _games[file.game].description));
+      continue;
+    }
+
+    if(!referenced.insert(make_pair(file.directory, file.game)).second)
+      continue;
+
+    makeRow(file, fields);
+    appendRow(fields, _newRows);
+    ++_stats.newRows;
+  } // end for(unsigned int ii = 0; ii < _files.size(); ++ii)
+}
+
+RomScanner::RomScanner():
+  d(new Private)
+{}
+
+RomScanner::~RomScanner()
+{
+  delete d;
+}
+
+bool RomScanner::addCatalog(const string& path)
+{
+  CatalogReader reader;
+  if(!reader.open(path))
+    return false;
+
+  // Macros whose value ends with an absolute directory, as the ROM path
+  // ending an emulator command line, or its --rompath= option
+  struct Candidate
+  {
+    string macro;
+    string directory;
+    bool byName;
+  };
+  MacroExpander macros;
+  vector<Candidate> candidates;
+  set<string> defined;
+
+  string_view line;
+  vector<string_view> split;
+  string expanded;
+  vector<Private::Row> rows;
+  while(reader.nextLine(line))
+  {
+    string_view first = line.substr(0, line.find(';'));
+    if(first == "MACRO")
+    {
+      CatalogReader::split(line, ';', split);
+      if(split.size() <= 2 || !defined.insert(string(split[1])).second)
+        continue;
+
+      macros.define(split[1], split[2]);
+      macros.expand(split[1], expanded);
+      string value = Private::trim(expanded);
+      string directory = value.substr(value.find_last_of(" =") + 1);
+      if(directory.size() > 1 && directory[0] == '/' && directory[directory.size() - 1] == '/')
+      {
+        // A space after the directory: the game is an argument of its own
+        Candidate candidate = {string(split[1]), directory, isspace((unsigned char) expanded[expanded.size() - 1]) != 0};
+        candidates.push_back(candidate);
+      }
+    }
+    else if(!first.empty() && first[0] != '#' && first != "PREPARE" && first != "COLLECTION")
+    {
+      CatalogReader::split(line, ';', split);
+      Private::Row row;
+      for(unsigned int ii = 0; ii < split.size() && ii < NUM_FIELDS; ++ii)
+        row.fields.push_back(Private::trim(split[ii]));
+      row.fields.resize(NUM_FIELDS);
+      row.directory = -1;
+      rows.push_back(row);
+    }
+  } // end while(reader.nextLine(line))
+
+  // Only the macros of game commands name ROM directories: the artwork
+  // macros end with a directory too
+  map<string, map<string, unsigned int> > devices, artMacros;
+  for(unsigned int ii = 0; ii < rows.size(); ++ii)
+  {
+    Private::Row& row = rows[ii];
+    const string& command = row.fields[FIELD_COMMAND];
+    for(unsigned int candidate = 0; candidate < candidates.size() && row.directory < 0; ++candidate)
+    {
+      const string& macro = candidates[candidate].macro;
+      size_t found = command.find(macro);
+      if(found == string::npos)
+        continue;
+
+      const string& path = candidates[candidate].directory;
+      for(unsigned int dir = 0; dir < d->_directories.size() && row.directory < 0; ++dir)
+      {
+        if(d->_directories[dir].path == path)
+          row.directory = dir;
+      }
+      if(row.directory < 0)
+      {
+        Private::Directory directory;
+        directory.path = path;
+        directory.macro = macro;
+        directory.byName = candidates[candidate].byName;
+        d->_directories.push_back(directory);
+        row.directory = d->_directories.size() - 1;
+      }
+      row.file = Private::trim(string_view(command).substr(found + macro.size()));
+
+      ++devices[path][row.fields[FIELD_DEVICE]];
+      const string& artwork = row.fields[FIELD_ARTWORK];
+      if(!artwork.empty() && artwork[0] == '<' && artwork.find('>') != string::npos)
+        ++artMacros[path][artwork.substr(0, artwork.find('>') + 1)];
+    } // end for(...)
+    d->_rows.push_back(row);
+  } // end for(unsigned int ii = 0; ii < rows.size(); ++ii)
+
+  // The device and artwork macro most rows of a directory use
+  for(unsigned int ii = 0; ii < d->_directories.size(); ++ii)
+  {
+    Private::Directory& directory = d->_directories[ii];
+    unsigned int best(0);
+    const map<string, unsigned int>& counts = devices[directory.path];
+    for(map<string, unsigned int>::const_iterator iter = counts.begin(); iter != counts.end(); ++iter)
+    {
+      if(iter->second > best)
+      {
+        best = iter->second;
+        directory.device = iter->first;
+      }
+    }
+    best = 0;
+    const map<string, unsigned int>& arts = artMacros[directory.path];
+    for(map<string, unsigned int>::const_iterator iter = arts.begin(); iter != arts.end(); ++iter)
+    {
+      if(iter->second > best)
+      {
+        best = iter->second;
+        directory.artMacro = iter->first;
+      }
+    }
+  } // end for(unsigned int ii = 0; ii < d->_directories.size(); ++ii)
+  return true;
+}
+
+bool RomScanner::loadDatabase(const string& path)
+{
+  CatalogReader reader;
+  if(!reader.open(path))
+    return false;
+
+  string_view line;
+  while(reader.nextLine(line))
+  {
+    string start = Private::trim(line);
+    if(start.empty())
+      continue;
+    reader.rewind();
+    if(start[0] == '<')
+      return d->loadDat(reader);
+    return d->loadCsv(reader);
+  }
+  return false;
+}
+
+void RomScanner::addDirectory(const string& directory)
+{
+  string path(directory);
+  if(!path.empty() && path[path.size() - 1] != '/')
+    path += '/';
+  d->_extraDirectories.push_back(path);
+}
+
+void RomScanner::scan(const string& cachePath, unsigned int numThreads)
+{
+  if(numThreads == 0)
+    numThreads = thread::hardware_concurrency();
+  if(numThreads == 0)
+    numThreads = 1;
+
+  d->walk(numThreads);
+  d->loadCache(cachePath);
+
+  // Unchanged files keep their CRC
+  vector<unsigned int> pending;
+  for(unsigned int ii = 0; ii < d->_files.size(); ++ii)
+  {
+    Private::File& file = d->_files[ii];
+    unordered_map<string, Private::File>::iterator cached = d->_cache.find(file.path);
+    if(cached != d->_cache.end() &&
+       cached->second.size == file.size &&
+       cached->second.mtime == file.mtime &&
+       cached->second.archive == (file.archive && !cached->second.members.empty()))
+    {
+      file.crc = cached->second.crc;
+      file.members.swap(cached->second.members);
+      file.checksummed = true;
+      ++d->_stats.cached;
+    }
+    else
+    {
+      pending.push_back(ii);
+    }
+    if(file.archive)
+      ++d->_stats.archives;
+  } // end for(unsigned int ii = 0; ii < d->_files.size(); ++ii)
+  d->_cache.clear();
+
+  // The other files are read by numThreads threads at once
+  Private::Checksums checksums;
+  checksums.scanner = d;
+  checksums.files = &pending;
+  checksums.next = 0;
+  checksums.bytesRead = 0;
+
+  vector<thread> threads;
+  for(unsigned int ii = 1; ii < numThreads && ii < pending.size(); ++ii)
+    threads.push_back(thread(Private::checksumQueuedFiles, &checksums));
+  Private::checksumQueuedFiles(&checksums);
+  for(unsigned int ii = 0; ii < threads.size(); ++ii)
+    threads[ii].join();
+  d->_stats.bytesRead = checksums.bytesRead;
+
+  for(unsigned int ii = 0; ii < d->_files.size(); ++ii)
+  {
+    if(d->_files[ii].checksummed)
+      ++d->_stats.checksummed;
+  }
+
+  d->saveCache(cachePath);
+  d->match();
+}
+
+bool RomScanner::writeRows(const string& path) const
+{
+  FILE* output = fopen(path.c_str(), "w");
+  if(output == NULL)
+    return false;
+
+  fprintf(output, "# ROM files renamed: these rows replace the rows of the same sort key\n");
+  fputs(d->_relocatedRows.c_str(), output);
+  fprintf(output, "# New games\n");
+  fputs(d->_newRows.c_str(), output);
+  return fclose(output) == 0;
+}
+
+bool RomScanner::writeReport(const string& path) const
+{
+  FILE* output = fopen(path.c_str(), "w");
+  if(output == NULL)
+    return false;
+
+  fprintf(output, "Missing ROM files (%u)\n", (unsigned int) d->_missing.size());
+  for(unsigned int ii = 0; ii < d->_missing.size(); ++ii)
+    fprintf(output, "  %s\n", d->_missing[ii].c_str());
+
+  fprintf(output, "\nUnidentified files (%u)\n", (unsigned int) d->_unidentified.size());
+  if(d->_roms.empty())
+    fprintf(output, "  No ROM database\n");
+  for(unsigned int ii = 0; ii < d->_unidentified.size(); ++ii)
+    fprintf(output, "  %s\n", d->_unidentified[ii].c_str());
+
+  fprintf(output, "\nGames outside of the catalog directories (%u)\n", (unsigned int) d->_elsewhere.size());
+  for(unsigned int ii = 0; ii < d->_elsewhere.size(); ++ii)
+    fprintf(output, "  %s\n", d->_elsewhere[ii].c_str());
+  return fclose(output) == 0;
+}
+
+RomScanner::Stats RomScanner::stats() const
+{
+  return d->_stats;
+}
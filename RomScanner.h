@@ -0,0 +1,68 @@
+#ifndef ROMSCANNER_H
+#define ROMSCANNER_H
+
+#include <string>
+
+// Keeps the catalog in sync with the ROM directories. The directories are
+// the ones ending the MACRO values of the catalogs, such as
+//   MACRO;<MD>;... PicoDrive -config ... /media/BBB/roms/gen_usa/
+// plus any directory added. They are walked in parallel and every file is
+// identified by its CRC-32 in a ROM database: a DAT file (the XML format of
+// clrmamepro and MAME) or a CSV file whose lines are
+//   CRC;Title;Short title;Sort key;Types;Device;Players;Family
+// Archives are identified by the CRCs of their members, read from the zip
+// directory without decompressing anything.
+//
+// CRCs are kept in a cache file keyed by path, size and modification time,
+// so that a second scan only reads the files that changed.
+class RomScanner
+{
+  public:
+    struct Stats
+    {
+      unsigned int directories;
+      unsigned int files;
+      unsigned int archives;
+      // Files whose CRC was computed, or found in the cache
+      unsigned int checksummed;
+      unsigned int cached;
+      unsigned long long bytesRead;
+      unsigned int identified;
+      unsigned int unidentified;
+      // Catalog rows whose ROM file is missing, relocated or not
+      unsigned int missing;
+      unsigned int relocated;
+      unsigned int newRows;
+    };
+
+    RomScanner();
+    ~RomScanner();
+
+    // MACRO lines give the ROM directories, game rows the files already in
+    // the catalog
+    bool addCatalog(const std::string& path);
+    bool loadDatabase(const std::string& path);
+    // Scanned too, for files outside of the catalog directories
+    void addDirectory(const std::string& directory);
+
+    // Uses numThreads threads, one per core with 0. cachePath may be empty.
+    void scan(const std::string& cachePath, unsigned int numThreads = 0);
+
+    // Catalog rows to merge into the catalog: rows whose ROM file was renamed,
+    // then new rows for the games found in the catalog directories
+    bool writeRows(const std::string& path) const;
+    // Missing ROM files, unidentified files, games found outside of the
+    // catalog directories
+    bool writeReport(const std::string& path) const;
+
+    Stats stats() const;
+
+  private:
+    RomScanner(const RomScanner&);
+    RomScanner& operator=(const RomScanner&);
+
+    class Private;
+    Private* d;
+};
+
+#endif // ROMSCANNER_H
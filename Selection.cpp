@@ -0,0 +1,98 @@
+#include "Selection.h"
+
+#include <algorithm>
+
+using namespace std;
+
+Selection::Selection():
+  _games(NULL),
+  _rows(),
+  _sections(),
+  _first(0),
+  _size(0),
+  _ranked(false)
+{}
+
+Selection::Selection(const GameTable* games, const Rows& rows, bool ranked, const Rows& sections):
+  _games(games),
+  _rows(rows),
+  _sections(sections),
+  _first(0),
+  _size(rows ? rows->size() : 0),
+  _ranked(ranked)
+{}
+
+unsigned int Selection::size() const
+{
+  return _size;
+}
+
+bool Selection::empty() const
+{
+  return _size == 0;
+}
+
+bool Selection::isRanked() const
+{
+  return _ranked;
+}
+
+unsigned int Selection::operator[](unsigned int index) const
+{
+  return (*_rows)[_first + index];
+}
+
+const unsigned int* Selection::begin() const
+{
+  return _size ? _rows->data() + _first : NULL;
+}
+
+const unsigned int* Selection::end() const
+{
+  return _size ? _rows->data() + _first + _size : NULL;
+}
+
+const GameTable* Selection::getTable() const
+{
+  return _games;
+}
+
+Game Selection::game(unsigned int index) const
+{
+  return Game(_games, (*_rows)[_first + index]);
+}
+
+Selection Selection::slice(unsigned int first, unsigned int count) const
+{
+  Selection result(*this);
+  if(first > _size)
+    first = _size;
+  if(count > _size - first)
+    count = _size - first;
+  result._first = _first + first;
+  result._size = count;
+  return result;
+}
+
+unsigned int Selection::nextSection(unsigned int index) const
+{
+  if(!_sections)
+    return _size;
+
+  // Sections index the whole rows, not the slice
+  vector<unsigned int>::const_iterator next = upper_bound(_sections->begin(), _sections->end(), _first + index);
+  if(next == _sections->end() || *next >= _first + _size)
+    return _size;
+  return *next - _first;
+}
+
+unsigned int Selection::previousSection(unsigned int index) const
+{
+  if(!_sections)
+    return 0;
+
+  vector<unsigned int>::const_iterator previous = lower_bound(_sections->begin(), _sections->end(), _first + index);
+  if(previous == _sections->begin() || *(previous - 1) < _first)
+    return 0;
+  return *(previous - 1) - _first;
+}
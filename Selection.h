@@ -0,0 +1,51 @@
+#ifndef SELECTION_H
+#define SELECTION_H
+
+#include <memory>
+#include <vector>
+#include "Content.h"
+
+// Read-only view on rows of selected games. The rows are shared by every
+// copy and slice of a view, and never modified once shared, so that views
+// can be passed around without copying them.
+class Selection
+{
+  public:
+    typedef std::shared_ptr<const std::vector<unsigned int> > Rows;
+
+    Selection();
+    // Ranked rows are sorted by relevance instead of position. sections
+    // holds the index of the first row of each letter, or more generally of
+    // each leading character of the sort order, in increasing order.
+    Selection(const GameTable* games, const Rows& rows, bool ranked = false, const Rows& sections = Rows());
+
+    unsigned int size() const;
+    bool empty() const;
+    bool isRanked() const;
+
+    unsigned int operator[](unsigned int index) const;
+    const unsigned int* begin() const;
+    const unsigned int* end() const;
+
+    const GameTable* getTable() const;
+    Game game(unsigned int index) const;
+
+    // Up to count rows starting at first
+    Selection slice(unsigned int first, unsigned int count) const;
+
+    // Index of the first row of the next letter after index, size() if there
+    // is none. Index of the first row of the letter of index, or of the
+    // previous letter if index is the first row, 0 if there is none.
+    unsigned int nextSection(unsigned int index) const;
+    unsigned int previousSection(unsigned int index) const;
+
+  private:
+    const GameTable* _games;
+    Rows _rows;
+    Rows _sections;
+    unsigned int _first;
+    unsigned int _size;
+    bool _ranked;
+};
+
+#endif // SELECTION_H
@@ -0,0 +1,115 @@
+#include "StringArena.h"
+
+using namespace std;
+
+// Marks an empty slot
+#define NO_STRING 0xFFFFFFFF
+
+StringArena::StringArena():
+  _buffer(),
+  _slots(),
+  _count(0),
+  _indexed(0)
+{}
+
+void StringArena::clear()
+{
+  _buffer.clear();
+  _slots.clear();
+  _count = 0;
+  _indexed = 0;
+}
+
+void StringArena::reserve(size_t size)
+{
+  _buffer.reserve(size);
+}
+
+size_t StringArena::size() const
+{
+  return _buffer.size();
+}
+
+uint64_t StringArena::hash(string_view str) const
+{
+  // FNV-1a
+  uint64_t res = 14695981039346656037ULL;
+  for(unsigned int ii = 0; ii < str.size(); ++ii)
+  {
+    res ^= (unsigned char) str[ii];
+    res *= 1099511628211ULL;
+  }
+  return res;
+}
+
+void StringArena::grow()
+{
+  unsigned int numSlots = _slots.empty() ? 1024 : _slots.size() * 2;
+  Ref empty = {0, NO_STRING};
+  _slots.assign(numSlots, empty);
+  _count = 0;
+
+  // Strings are stored back to back, each followed by its '\0'
+  uint32_t offset(_indexed);
+  while(offset < _buffer.size())
+  {
+    size_t end = _buffer.find('\0', offset);
+    if(end == string::npos)
+      break;
+    Ref ref = {offset, (uint32_t) (end - offset)};
+    unsigned int slot = hash(view(ref)) & (numSlots - 1);
+    while(_slots[slot].length != NO_STRING)
+      slot = (slot + 1) & (numSlots - 1);
+    _slots[slot] = ref;
+    ++_count;
+    offset += ref.length + 1;
+  }
+}
+
+StringArena::Ref StringArena::intern(string_view str)
+{
+  // At most half full
+  if(2 * (_count + 1) > _slots.size())
+    grow();
+
+  unsigned int slot = hash(str) & (_slots.size() - 1);
+  while(_slots[slot].length != NO_STRING)
+  {
+    if(view(_slots[slot]) == str)
+      return _slots[slot];
+    slot = (slot + 1) & (_slots.size() - 1);
+  }
+
+  Ref res = {(uint32_t) _buffer.size(), (uint32_t) str.size()};
+  _buffer.append(str.data(), str.size());
+  _buffer += '\0';
+  _slots[slot] = res;
+  ++_count;
+  return res;
+}
+
+string_view StringArena::view(Ref ref) const
+{
+  return string_view(_buffer.data() + ref.offset, ref.length);
+}
+
+void StringArena::shrink()
+{
+  _buffer.shrink_to_fit();
+  vector<Ref>().swap(_slots);
+  _count = 0;
+  _indexed = _buffer.size();
+}
+
+const string& StringArena::buffer() const
+{
+  return _buffer;
+}
+
+void StringArena::assign(string_view buffer)
+{
+  _buffer.assign(buffer.data(), buffer.size());
+  vector<Ref>().swap(_slots);
+  _count = 0;
+  _indexed = _buffer.size();
+}
@@ -0,0 +1,50 @@
+#ifndef STRINGARENA_H
+#define STRINGARENA_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+
+// Append-only store for the text of the catalog: every string is copied
+// once at the end of a single buffer, followed by a '\0', and referenced by
+// offset. Identical strings are stored once.
+class StringArena
+{
+  public:
+    struct Ref
+    {
+      uint32_t offset;
+      uint32_t length;
+    };
+
+    StringArena();
+
+    void clear();
+    void reserve(size_t size);
+    size_t size() const;
+
+    Ref intern(std::string_view str);
+    std::string_view view(Ref ref) const;
+
+    // Frees the unused capacity and the deduplication index, once loaded.
+    // Strings interned afterwards are only deduplicated among themselves.
+    void shrink();
+
+    // Raw content, for GameTable::save() and load()
+    const std::string& buffer() const;
+    void assign(std::string_view buffer);
+
+  private:
+    uint64_t hash(std::string_view str) const;
+    void grow();
+
+    std::string _buffer;
+    // Open addressing table of the stored strings, rebuilt when needed
+    std::vector<Ref> _slots;
+    unsigned int _count;
+    // Offset of the first string indexed: the ones before it are loaded
+    uint32_t _indexed;
+};
+
+#endif // STRINGARENA_H
@@ -0,0 +1,205 @@
+#include "CatalogGenerator.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+  struct Device
+  {
+    const char* name;
+    const char* macro;
+    const char* command;
+    const char* extension;
+  };
+
+  const Device devices[] =
+  {
+    {"Megadrive", "MD", "NO_MENU=1 /media/BBB/sources/picodrive/picodrive/PicoDrive -config /root/.picodrive/config2.cfg /media/BBB/roms/gen_usa/", ".md"},
+    {"NES", "NES", "advmess nes -cart ", ".nes"},
+    {"Super NES", "SNES", "/media/BBB/sources/snes9x-sdl-master-optim/sdl/snes9x-sdl -nomp5 -port1 pad1 -port2 pad2 /media/BBB/roms/snes/", ".sfc"},
+    {"Master System", "MS", "NO_MENU=1 /media/BBB/sources/picodrive/picodrive/PicoDrive /media/BBB/roms/sms/", ".sms"},
+    {"Game Boy", "GB", "advmess gameboy -cart ", ".gb"},
+    {"Game Gear", "GG", "advmess gamegear -cart ", ".gg"},
+    {"Playstation", "PSX", "NO_MENU=1 /media/BBB/sources/pcsx_rearmed/pcsx -cdfile /media/BBB/roms/psx/", ".cue"},
+    {"Neo-Geo", "NG", "gngeo-0.7 --scale=3 --rompath=/media/BBB/roms/neogeo/ ", ".zip"},
+    {"Arcade", "ARCADE", "advmame ", ""},
+    {"PC Engine", "ENGINE", "advmess pce -cart ", ".pce"},
+    {"Game Boy Color", "GBC", "advmess gbcolor -cart ", ".gbc"},
+    {"Lynx", "LYNX", "advmess lynx -cart ", ".lnx"},
+    {"Jaguar", "JAG", "virtualjaguar ", ".j64"},
+    {"PC", "PC", "dosbox ", ".exe"}
+  };
+  const unsigned int numDevices = sizeof(devices) / sizeof(devices[0]);
+
+  const char* const types[] =
+  {
+    "Plate-forme", "Action", "Baston", "Course", "Shooter", "Aventure",
+    "Role", "Sport", "Puzzle", "Beat'em all", "Réflexion", "Simulation",
+    "Stratégie", "Party", "Musique", "Flipper", "Tir", "Combat"
+  };
+  const unsigned int numTypes = sizeof(types) / sizeof(types[0]);
+
+  const char* const words[] =
+  {
+    "Super", "Street", "Fighter", "Mario", "Sonic", "Hedgehog", "Legend",
+    "Zelda", "Mega", "Man", "Castle", "Dragon", "Quest", "Final", "Fantasy",
+    "Wonder", "Boy", "Shinobi", "Golden", "Axe", "Streets", "Rage", "Metal",
+    "Slug", "Kombat", "Mortal", "Batman", "Robin", "Donkey", "Kong", "Tetris",
+    "Bomberman", "Contra", "Castlevania", "Gunstar", "Heroes", "Ecco",
+    "Dolphin", "Aladdin", "Lion", "King", "Jungle", "Book", "Earthworm", "Jim",
+    "Vectorman", "Toejam", "Earl", "Phantasy", "Star", "Shining", "Force",
+    "Soleil", "Landstalker", "Thunder", "Blade", "Space", "Harrier", "Out",
+    "Run", "Turbo", "Rally", "Racing", "Kart", "World", "Cup", "Soccer",
+    "Pinball", "Puzzle", "Bobble", "Bubble", "Snow", "Bros", "Ninja", "Turtles",
+    "Éclair", "Château", "Détective", "Fêtes", "Noël", "Ôde", "Zoé"
+  };
+  const unsigned int numWords = sizeof(words) / sizeof(words[0]);
+
+  const char* const articles[] = {"The ", "A ", "Le ", "La ", "Les ", "L'"};
+  const unsigned int numArticles = sizeof(articles) / sizeof(articles[0]);
+
+  const char* const suffixes[] = {" II", " III", " 2", " 3", " 64", " Deluxe", " Special", ": Remix"};
+  const unsigned int numSuffixes = sizeof(suffixes) / sizeof(suffixes[0]);
+
+  const char* const players[] = {"1", "1", "1", "1", "1", "2", "2", "2", "4", "8"};
+  const unsigned int numPlayers = sizeof(players) / sizeof(players[0]);
+}
+
+CatalogGenerator::CatalogGenerator(uint64_t seed):
+  _state(seed ? seed : 1)
+{}
+
+uint64_t CatalogGenerator::random()
+{
+  // xorshift64*
+  _state ^= _state >> 12;
+  _state ^= _state << 25;
+  _state ^= _state >> 27;
+  return _state * 2685821657736338717ULL;
+}
+
+unsigned int CatalogGenerator::uniform(unsigned int count)
+{
+  return (random() >> 32) % count;
+}
+
+unsigned int CatalogGenerator::skewed(unsigned int count)
+{
+  // Smallest of three draws: value ii is about (count - ii)^2 times likelier
+  // than the last one
+  unsigned int value = uniform(count);
+  for(unsigned int ii = 0; ii < 2; ++ii)
+  {
+    unsigned int other = uniform(count);
+    if(other < value)
+      value = other;
+  }
+  return value;
+}
+
+void CatalogGenerator::makeName(string& name, string& shortName)
+{
+  name.clear();
+  if(uniform(8) == 0)
+    name.append(articles[uniform(numArticles)]);
+
+  string title;
+  unsigned int numWordsInName = 1 + uniform(4);
+  for(unsigned int ii = 0; ii < numWordsInName; ++ii)
+  {
+    if(ii > 0)
+      title.append(" ");
+    title.append(words[skewed(numWords)]);
+  }
+  name.append(title);
+
+  if(uniform(4) == 0)
+    name.append(suffixes[uniform(numSuffixes)]);
+
+  shortName = title;
+}
+
+bool CatalogGenerator::generate(const string& path, unsigned int numGames)
+{
+  FILE* file = fopen(path.c_str(), "w");
+  if(file == NULL)
+    return false;
+
+  fprintf(file, "PREPARE;true;\n");
+  fprintf(file, "MACRO;<ART>;/media/BBB/pixbox/resources/art/\n");
+  for(unsigned int ii = 0; ii < numDevices; ++ii)
+  {
+    fprintf(file, "MACRO;<%s>;%s\n", devices[ii].macro, devices[ii].command);
+    fprintf(file, "MACRO;<%sART>;<ART>%s/\n", devices[ii].macro, devices[ii].macro);
+  }
+  fprintf(file, "#Titre;Titre court;Clef de tri;Type;Machine;Nb joueurs;Famille;Artwork;Commande\n");
+
+  // Families are named after their first game. Big catalogs have more
+  // families.
+  unsigned int numFamilies = numGames / 20 + 1;
+  vector<string> families;
+
+  string name, shortName, sortKey, gameTypes;
+  char number[16];
+  for(unsigned int game = 0; game < numGames; ++game)
+  {
+    // Artwork directories move from time to time
+    if(game > 0 && game % 5000 == 0)
+      fprintf(file, "MACRO;<ART>;/media/BBB/pixbox/resources/art%u/\n", game / 5000);
+
+    const Device& device = devices[skewed(numDevices)];
+    makeName(name, shortName);
+
+    // Unique sort keys, in file order unrelated to name order
+    sortKey.clear();
+    for(string::const_iterator iter = shortName.begin(); iter != shortName.end(); ++iter)
+    {
+      char character = *iter;
+      if(character >= 'A' && character <= 'Z')
+        character += 'a' - 'A';
+      sortKey += (character == ' ') ? '-' : character;
+    }
+    snprintf(number, sizeof(number), "-%u", game);
+    sortKey.append(number);
+
+    gameTypes.clear();
+    unsigned int numGameTypes = 1 + skewed(3);
+    for(unsigned int ii = 0; ii < numGameTypes; ++ii)
+    {
+      if(ii > 0)
+        gameTypes.append("%");
+      gameTypes.append(types[skewed(numTypes)]);
+    }
+
+    string family;
+    if(uniform(10) < 3)
+    {
+      unsigned int index = skewed(numFamilies);
+      if(index >= families.size())
+      {
+        families.push_back(shortName);
+        index = families.size() - 1;
+      }
+      family = families[index];
+    }
+
+    fprintf(file, "%s;%s;%s;%s;%s;%s;%s;<%sART>%s.png;<%s>%s%s\n",
+            name.c_str(),
+            shortName.c_str(),
+            sortKey.c_str(),
+            gameTypes.c_str(),
+            device.name,
+            players[uniform(numPlayers)],
+            family.c_str(),
+            device.macro, sortKey.c_str(),
+            device.macro, name.c_str(), device.extension);
+
+    if(uniform(200) == 0)
+      fprintf(file, "# %s\n", name.c_str());
+  } // end for(unsigned int game = 0; game < numGames; ++game)
+
+  return fclose(file) == 0;
+}
@@ -0,0 +1,29 @@
+#ifndef CATALOGGENERATOR_H
+#define CATALOGGENERATOR_H
+
+#include <string>
+#include <stdint.h>
+
+// Writes synthetic pixbox.csv catalogs shaped like real ones: a few
+// devices holding most games, one to three types per game, families for a
+// minority of games with a few big ones, and MACRO lines for commands and
+// artwork, some redefined along the file. The same seed gives the same file.
+class CatalogGenerator
+{
+  public:
+    explicit CatalogGenerator(uint64_t seed = 1);
+
+    bool generate(const std::string& path, unsigned int numGames);
+
+  private:
+    uint64_t random();
+    // Between 0 and count - 1, low values much more often
+    unsigned int skewed(unsigned int count);
+    unsigned int uniform(unsigned int count);
+
+    void makeName(std::string& name, std::string& shortName);
+
+    uint64_t _state;
+};
+
+#endif // CATALOGGENERATOR_H
@@ -0,0 +1,314 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CatalogGenerator.h"
+#include "../Content.h"
+#include "../GraphicStatus.h"
+#include "../Selection.h"
+
+// Catalog engine benchmark: Content and GraphicStatus on synthetic
+// catalogs, without SDL. Timings are written on stdout as JSON.
+//
+//   pixbox_bench [-d directory] [-s seed] [rows...]
+
+using namespace std;
+
+namespace
+{
+  typedef chrono::steady_clock Clock;
+
+  double elapsed(Clock::time_point start)
+  {
+    return chrono::duration<double, micro>(Clock::now() - start).count();
+  }
+
+  // Duration of repeated calls, in microseconds
+  class Timing
+  {
+    public:
+      Timing(const char* name):
+        _name(name),
+        _calls(0),
+        _total(0.),
+        _max(0.)
+      {}
+
+      void add(double duration)
+      {
+        ++_calls;
+        _total += duration;
+        if(duration > _max)
+          _max = duration;
+      }
+
+      unsigned int calls() const
+      {
+        return _calls;
+      }
+
+      void print(bool last) const
+      {
+        printf("        \"%s\": {\"calls\": %u, \"total_us\": %.1f, \"mean_us\": %.3f, \"max_us\": %.1f}%s\n",
+               _name, _calls, _total, _calls ? _total / _calls : 0., _max, last ? "" : ",");
+      }
+
+    private:
+      const char* _name;
+      unsigned int _calls;
+      double _total;
+      double _max;
+  };
+
+  // Every value of a facet once, back to the first one
+  void cycle(Content& content, const string& (Content::*step)(), Timing& timing)
+  {
+    string first;
+    do
+    {
+      Clock::time_point start = Clock::now();
+      const string& value = (content.*step)();
+      timing.add(elapsed(start));
+      if(timing.calls() == 1)
+        first = value;
+      else if(value == first)
+        break;
+    } while(timing.calls() < 100000);
+  }
+
+  // Drops the selections kept by the facet cube, counted as evictions
+  void dropCube(Content& content)
+  {
+    size_t capacity = content.facetCubeStats().capacity;
+    content.setFacetCubeCapacity(0);
+    content.setFacetCubeCapacity(capacity);
+  }
+
+  // Every value of a facet from an empty cube, then again from the
+  // selections it kept, back to the value the facet had
+  void cycle(Content& content,
+             const string& (Content::*step)(),
+             const string& (Content::*current)() const,
+             Timing& timing,
+             Timing& cached)
+  {
+    string start = (content.*current)();
+    dropCube(content);
+    cycle(content, step, timing);
+    cycle(content, step, cached);
+    for(unsigned int ii = 0; ii < 100000 && (content.*current)() != start; ++ii)
+      (content.*step)();
+  }
+
+  void run(const string& directory, unsigned int numGames, uint64_t seed, bool last)
+  {
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "-%u", numGames);
+    string dataFile = directory + "/pixbox-bench" + suffix + ".csv";
+    string cacheFile = directory + "/pixbox-bench" + suffix + ".cache";
+
+    Clock::time_point start = Clock::now();
+    CatalogGenerator generator(seed);
+    if(!generator.generate(dataFile, numGames))
+    {
+      fprintf(stderr, "Cannot write %s\n", dataFile.c_str());
+      exit(1);
+    }
+    double generate = elapsed(start);
+
+    Content content;
+    content.startAddingGames();
+    start = Clock::now();
+    content.addGames(dataFile);
+    double loadFile = elapsed(start);
+    start = Clock::now();
+    content.stopAddingGames();
+    double stopAddingGames = elapsed(start);
+
+    remove(cacheFile.c_str());
+    double init[2];
+    for(unsigned int ii = 0; ii < 2; ++ii)
+    {
+      // Without the cache file, then with it
+      Content loaded;
+      start = Clock::now();
+      loaded.init(dataFile, cacheFile);
+      init[ii] = elapsed(start);
+      loaded.quit();
+    }
+
+    Timing filters[8] =
+    {
+      "nextGameType", "previousGameType", "nextDevice", "previousDevice",
+      "nextMultiplayer", "previousMultiplayer", "nextGameFamily", "previousGameFamily"
+    };
+    // Combinations seen already come from the facet cube
+    Timing cached[8] =
+    {
+      "nextGameType_cached", "previousGameType_cached", "nextDevice_cached", "previousDevice_cached",
+      "nextMultiplayer_cached", "previousMultiplayer_cached", "nextGameFamily_cached", "previousGameFamily_cached"
+    };
+    cycle(content, &Content::nextGameType, &Content::currentGameType, filters[0], cached[0]);
+    cycle(content, &Content::previousGameType, &Content::currentGameType, filters[1], cached[1]);
+    cycle(content, &Content::nextDevice, &Content::currentDevice, filters[2], cached[2]);
+    cycle(content, &Content::previousDevice, &Content::currentDevice, filters[3], cached[3]);
+    cycle(content, &Content::nextMultiplayer, &Content::currentMultiplayer, filters[4], cached[4]);
+    cycle(content, &Content::previousMultiplayer, &Content::currentMultiplayer, filters[5], cached[5]);
+    cycle(content, &Content::nextGameFamily, &Content::currentGameFamily, filters[6], cached[6]);
+    cycle(content, &Content::previousGameFamily, &Content::currentGameFamily, filters[7], cached[7]);
+
+    // Types cycled again under a device filter, as in the GUI
+    Timing filtered("nextGameType_with_device");
+    dropCube(content);
+    content.nextDevice();
+    cycle(content, &Content::nextGameType, filtered);
+    content.previousDevice();
+
+    Timing setCurrentGames("setCurrentGames");
+    Timing nextPage("nextPage");
+    Timing previousPage("previousPage");
+    Timing nextGame("nextGame");
+    Timing previousGame("previousGame");
+    GraphicStatus status;
+    start = Clock::now();
+    status.setCurrentGames(content.currentSelection());
+    setCurrentGames.add(elapsed(start));
+    unsigned int numPages = content.currentSelection().size() / NUM_GAMES + 1;
+    for(unsigned int ii = 0; ii < numPages; ++ii)
+    {
+      start = Clock::now();
+      status.nextPage();
+      nextPage.add(elapsed(start));
+    }
+    for(unsigned int ii = 0; ii < numPages; ++ii)
+    {
+      start = Clock::now();
+      status.previousPage();
+      previousPage.add(elapsed(start));
+    }
+    for(unsigned int ii = 0; ii < 10 * NUM_GAMES; ++ii)
+    {
+      start = Clock::now();
+      status.nextGame();
+      nextGame.add(elapsed(start));
+    }
+    for(unsigned int ii = 0; ii < 10 * NUM_GAMES; ++ii)
+    {
+      start = Clock::now();
+      status.previousGame();
+      previousGame.add(elapsed(start));
+    }
+    // Cursor restored after a filter change
+    content.nextDevice();
+    start = Clock::now();
+    status.setCurrentGames(content.currentSelection());
+    setCurrentGames.add(elapsed(start));
+    content.previousDevice();
+
+    // Type-ahead, then a typo only the fuzzy search finds
+    Timing search("appendToSearch");
+    const char* const queries[] = {"super street", "sonik hedgehg"};
+    for(unsigned int ii = 0; ii < 2; ++ii)
+    {
+      content.startSearch();
+      for(const char* character = queries[ii]; *character; ++character)
+      {
+        start = Clock::now();
+        content.appendToSearch(*character);
+        search.add(elapsed(start));
+      }
+      content.stopSearch();
+    }
+
+    // Before queries drop the cube entries
+    FacetCube::Stats cube = content.facetCubeStats();
+
+    // Filter queries, each one compiled and evaluated over the bitsets
+    Timing query("setQuery");
+    const char* const filterQueries[] =
+    {
+      "type:baston players:2 (device:neo-geo or device:arcade)",
+      "type:shooter and not device:\"game boy\"",
+      "not (type:action or type:plate-forme) and name:super",
+      ""
+    };
+    string message;
+    for(unsigned int ii = 0; ii < 4; ++ii)
+    {
+      start = Clock::now();
+      content.setQuery(filterQueries[ii], message);
+      query.add(elapsed(start));
+    }
+
+    printf("    {\n");
+    printf("      \"rows\": %u,\n", numGames);
+    printf("      \"games\": %u,\n", content.games().size());
+    printf("      \"generate_us\": %.1f,\n", generate);
+    printf("      \"loadFile_us\": %.1f,\n", loadFile);
+    printf("      \"stopAddingGames_us\": %.1f,\n", stopAddingGames);
+    printf("      \"init_us\": %.1f,\n", init[0]);
+    printf("      \"init_cached_us\": %.1f,\n", init[1]);
+    printf("      \"facet_cube\": {\"entries\": %u, \"bytes\": %zu, \"capacity\": %zu, \"hits\": %llu, \"misses\": %llu, \"evictions\": %llu},\n",
+           cube.entries, cube.bytes, cube.capacity,
+           (unsigned long long) cube.hits, (unsigned long long) cube.misses, (unsigned long long) cube.evictions);
+    printf("      \"operations\":\n");
+    printf("      {\n");
+    for(unsigned int ii = 0; ii < 8; ++ii)
+      filters[ii].print(false);
+    for(unsigned int ii = 0; ii < 8; ++ii)
+      cached[ii].print(false);
+    filtered.print(false);
+    setCurrentGames.print(false);
+    nextPage.print(false);
+    previousPage.print(false);
+    nextGame.print(false);
+    previousGame.print(false);
+    query.print(false);
+    search.print(true);
+    printf("      }\n");
+    printf("    }%s\n", last ? "" : ",");
+    fflush(stdout);
+
+    remove(dataFile.c_str());
+    remove(cacheFile.c_str());
+  }
+}
+
+int main(int argc, char** argv)
+{
+  string directory("/tmp");
+  uint64_t seed(1);
+  vector<unsigned int> sizes;
+  for(int ii = 1; ii < argc; ++ii)
+  {
+    if(!strcmp(argv[ii], "-d") && ii + 1 < argc)
+      directory = argv[++ii];
+    else if(!strcmp(argv[ii], "-s") && ii + 1 < argc)
+      seed = strtoull(argv[++ii], NULL, 10);
+    else
+      sizes.push_back(strtoul(argv[ii], NULL, 10));
+  }
+  if(sizes.empty())
+  {
+    sizes.push_back(1000);
+    sizes.push_back(10000);
+    sizes.push_back(100000);
+    sizes.push_back(1000000);
+  }
+
+  printf("{\n");
+  printf("  \"benchmark\": \"pixbox-catalog\",\n");
+  printf("  \"seed\": %llu,\n", (unsigned long long) seed);
+  printf("  \"threads\": %u,\n", thread::hardware_concurrency());
+  printf("  \"results\":\n");
+  printf("  [\n");
+  for(unsigned int ii = 0; ii < sizes.size(); ++ii)
+    run(directory, sizes[ii], seed, ii + 1 == sizes.size());
+  printf("  ]\n");
+  printf("}\n");
+
+  return 0;
+}
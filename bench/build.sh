@@ -0,0 +1,5 @@
+#!/bin/bash
+
+# Catalog engine benchmark, without SDL: everything but the GUI sources
+cd "$(dirname "$0")"
+g++ -O2 -std=c++17 -pthread $CFLAGS $(ls ../*.cpp | grep -v -e GraphicElements.cpp -e PixBox.cpp -e main.cpp) *.cpp -o pixbox_bench
@@ -1,5 +1,5 @@
 #!/bin/bash
 
-g++ -L/media/BBB/lib -I/media/BBB/include/SDL  -lSDL -lSDL_image -lSDL_ttf -lSDL_mixer $CFLAGS *.cpp -o pixbox_gui
+g++ -L/media/BBB/lib -I/media/BBB/include/SDL  -lSDL -lSDL_image -lSDL_ttf -lSDL_mixer -std=c++17 -pthread $CFLAGS *.cpp -o pixbox_gui
 
 
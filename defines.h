@@ -7,6 +7,14 @@
 // Number of games per screen
 #define NUM_GAMES 20
 
+// Cursor after a filter change: 0 on the highlighted game or the next one,
+// 1 on the highlighted game or back to the first one
+#define CURSOR_STICKS_TO_GAME 0
+
+// Memory kept for the selections of the filter combinations already seen,
+// in bytes. Content::quit() logs how much was used.
+#define FACET_CUBE_CAPACITY (8 * 1024 * 1024)
+
 // Resources: "database", graphics, sounds
 #define MAX_SHORTNAME_LENGTH 20
 #ifdef WIN32
@@ -15,6 +23,21 @@
 #define RESOURCE_PATH(resource) (string("/media/BBB/pixbox/resources/")+resource)
 #endif
 #define DATA_FILE "pixbox.csv"
+#define CACHE_FILE "pixbox.cache"
+// Directory of catalog shards, e.g. one CSV file per system, used instead
+// of DATA_FILE when it holds any
+#define SHARD_DIRECTORY "catalogs"
+// Edits of the catalog appended to it (see CatalogJournal), next to
+// DATA_FILE or in SHARD_DIRECTORY. Content::init() writes them into the
+// catalog once there are that many.
+#define JOURNAL_FILE "pixbox.journal"
+#define JOURNAL_COMPACTION_THRESHOLD 100
+// pixbox_gui --scan: ROM database (DAT or CSV), CRC cache, rows to merge
+// into the catalog and report of the missing files
+#define ROM_DATABASE "roms.dat"
+#define ROM_CHECKSUM_CACHE "roms.crc"
+#define SCAN_ROWS "pixbox-scan.csv"
+#define SCAN_REPORT "pixbox-missing.txt"
 #define BACKGROUND_IMAGE "pixbox-interface3.png"
 #define SOUND_ONE "smb_coin.wav"
 #define SOUND_TWO "smb_bump.wav"
@@ -26,3 +49,5 @@
 #define TEXT_GAME_FAMILY "Famille"
 #define TEXT_GAME "Jeu"
 #define TEXT_ALL "Tout"
+#define TEXT_SEARCH "Recherche"
+#define TEXT_COLLECTION "Collection"
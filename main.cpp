@@ -1,7 +1,13 @@
 #include "PixBox.h"
+#include <chrono>
+#include <cstring>
 #include <ctime>
+#include "CatalogReader.h"
+#include "RomScanner.h"
 #undef main
 
+using namespace std;
+
 void printPix()
 {
 printf("____                 ____                     \\n"
@@ -13,8 +19,49 @@ printf("____                 ____                     \\n"
        "    \\/_/    \\/_/\\//\\/_/  \\/___/  \\/___/ \\//\\/_/\\n");
 }
 
-int main(int argc, char **)
+// pixbox_gui --scan [database] [directory...]
+// Scans the ROM directories of the catalog, and the directories given, and
+// writes the rows and report next to the catalog. No SDL involved.
+int scan(int argc, char **argv)
+{
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  RomScanner scanner;
+  vector<string> catalogs;
+  if(!CatalogReader::list(RESOURCE_PATH(SHARD_DIRECTORY), ".csv", catalogs) || catalogs.empty())
+    catalogs.push_back(RESOURCE_PATH(DATA_FILE));
+  for(unsigned int ii = 0; ii < catalogs.size(); ++ii)
+  {
+    if(!scanner.addCatalog(catalogs[ii]))
+      printf("Can't read %s\n", catalogs[ii].c_str());
+  }
+
+  string database = argc > 2 ? string(argv[2]) : RESOURCE_PATH(ROM_DATABASE);
+  if(!scanner.loadDatabase(database))
+    printf("Can't read the ROM database %s: files won't be identified\n", database.c_str());
+  for(int ii = 3; ii < argc; ++ii)
+    scanner.addDirectory(argv[ii]);
+
+  scanner.scan(RESOURCE_PATH(ROM_CHECKSUM_CACHE));
+  scanner.writeRows(RESOURCE_PATH(SCAN_ROWS));
+  scanner.writeReport(RESOURCE_PATH(SCAN_REPORT));
+
+  RomScanner::Stats stats = scanner.stats();
+  printf("%u directories, %u files (%u archives), %u checksummed of which %u cached, %llu bytes read\n",
+         stats.directories, stats.files, stats.archives, stats.checksummed, stats.cached, stats.bytesRead);
+  printf("%u identified, %u unidentified, %u ROM files missing (%u renamed), %u new games\n",
+         stats.identified, stats.unidentified, stats.missing, stats.relocated, stats.newRows);
+  printf("Rows in %s, report in %s (%.1f s)\n",
+         RESOURCE_PATH(SCAN_ROWS).c_str(), RESOURCE_PATH(SCAN_REPORT).c_str(),
+         chrono::duration<double>(chrono::steady_clock::now() - start).count());
+  return 0;
+}
+
+int main(int argc, char **argv)
 {
+  if(argc > 1 && strcmp(argv[1], "--scan") == 0)
+    return scan(argc, argv);
+
   srand(time(NULL));
 
   printPix();